@@ -0,0 +1,249 @@
+#include "calipers.h"
+
+/**
+ * Rotating calipers [Tou83] on a convex hull, given as the indices of its
+ * vertices in the order of convexHullIndices() (ccw() > 0 along the hull).
+ * For every edge the sweep keeps three vertices: the last one ahead along
+ * the edge, the farthest one from the edge, and the last one behind along
+ * the edge. As the edges turn around the hull each of these only moves
+ * forward, so they are found for all edges in O(h) time:
+ *   - Every antipodal pair (vertices on two parallel supporting lines) is an
+ *     end of an edge together with a vertex farthest from that edge, and the
+ *     diameter is the longest of them.
+ *   - The width is the smallest distance of an edge to its farthest vertex.
+ *   - The enclosing rectangles of smallest area [FS75] and of smallest
+ *     perimeter have a side on the line of an edge, and the three vertices
+ *     touch the other sides.
+ * Whether a vertex moves on is decided by the exact sign of the cross or
+ * dot product of two edges; lengths and rectangles are computed in double
+ * precision.
+ */
+
+struct calipers {
+    const point *Points;
+    const int *hull;
+    int h;
+};
+
+static const point *vertex(const struct calipers *C, int k) {
+    return &C->Points[C->hull[k % C->h]];
+}
+
+// Sign of the cross product of edges i and j (vertex j+1 is farther from
+// edge i than vertex j if it is positive)
+static int edgeCross(const struct calipers *C, int i, int j) {
+    const point *a = vertex(C, i), *b = vertex(C, i+1), *c = vertex(C, j), *d = vertex(C, j+1);
+    return crossSign((long long)b->x - a->x, (long long)b->y - a->y,
+                     (long long)d->x - c->x, (long long)d->y - c->y);
+}
+
+// Sign of the dot product of edges i and j, the cross product with edge j
+// turned by 90 degrees (vertex j+1 is ahead of vertex j along edge i if it
+// is positive)
+static int edgeDot(const struct calipers *C, int i, int j) {
+    const point *a = vertex(C, i), *b = vertex(C, i+1), *c = vertex(C, j), *d = vertex(C, j+1);
+    return crossSign((long long)b->x - a->x, (long long)b->y - a->y,
+                     -((long long)d->y - c->y), (long long)d->x - c->x);
+}
+
+static double distance2(const point *a, const point *b) {
+    double dx = (double)b->x - a->x, dy = (double)b->y - a->y;
+    return dx*dx + dy*dy;
+}
+
+// Takes vertices i and j as the diameter if they are farther apart
+static void diameterPair(const struct calipers *C, int i, int j, double *best,
+                         struct hullMeasures *m) {
+    double d = distance2(vertex(C, i), vertex(C, j));
+    if (d > *best) {
+        *best = d;
+        m->diameterPair[0] = i % C->h;
+        m->diameterPair[1] = j % C->h;
+    }
+}
+
+// The rectangle on edge i from lo to hi along the unit vector u, of height
+// height in the direction turned to the left (into the hull)
+static void rectangle(const struct calipers *C, int i, double ux, double uy,
+                      double lo, double hi, double height, struct hullRectangle *r) {
+    const point *a = vertex(C, i);
+    double along[4] = { lo, hi, hi, lo }, across[4] = { 0, 0, height, height };
+    for (int k=0; k<4; k++) {
+        r->x[k] = a->x + along[k]*ux - across[k]*uy;
+        r->y[k] = a->y + along[k]*uy + across[k]*ux;
+    }
+    r->width = hi - lo;
+    r->height = height;
+    r->edge = i % C->h;
+}
+
+// Measures of a hull of one or two vertices (a point or a segment)
+static void smallMeasures(const struct calipers *C, struct hullMeasures *m) {
+    int last = C->h - 1;
+    const point *a = vertex(C, 0), *b = vertex(C, last);
+    double length = sqrt(distance2(a, b)), ux = 1, uy = 0;
+    if (length > 0) {
+        ux = ((double)b->x - a->x) / length;
+        uy = ((double)b->y - a->y) / length;
+    }
+    m->diameter = length;
+    m->diameterPair[0] = 0;
+    m->diameterPair[1] = last;
+    m->width = 0;
+    m->widthEdge = 0;
+    m->widthVertex = last;
+    rectangle(C, 0, ux, uy, 0, length, 0, &m->minArea);
+    m->minPerimeter = m->minArea;
+}
+
+/**
+ * Computes the diameter, the width and the enclosing rectangles of smallest
+ * area and smallest perimeter of a convex hull in O(h) time.
+ * @param  Points A set of points (in the plane)
+ * @param  hull   Indices into Points of the vertices of CH(P) in the order
+ *                of convexHullIndices()
+ * @param  h      Number of vertices, at least 1
+ * @param  m      Receives the measures
+ */
+void hullCalipers(const point *Points, const int *hull, int h, struct hullMeasures *m) {
+    struct calipers C = { Points, hull, h };
+    memset(m, 0, sizeof(*m));
+    if (h <= 0) return;
+    if (h <= 2) {
+        smallMeasures(&C, m);
+        return;
+    }
+
+    double diameter2 = -1, bestArea = HUGE_VAL, bestPerimeter = HUGE_VAL;
+    m->width = HUGE_VAL;
+    int ahead = 1, far = 1, behind = 1;
+    for (int i=0; i<h; i++) {
+        // Move on the vertices (never more than once around the hull)
+        ahead = max(ahead, i+1);
+        while (ahead < i+h && edgeDot(&C, i, ahead) > 0)
+            ahead++;
+        far = max(far, ahead);
+        while (far < i+h && edgeCross(&C, i, far) > 0)
+            far++;
+        behind = max(behind, far);
+        while (behind < i+h && edgeDot(&C, i, behind) < 0)
+            behind++;
+
+        diameterPair(&C, i, far, &diameter2, m);
+        diameterPair(&C, i+1, far, &diameter2, m);
+        if (edgeCross(&C, i, far) == 0) {
+            // An edge parallel to edge i, both of its ends are farthest
+            diameterPair(&C, i, far+1, &diameter2, m);
+            diameterPair(&C, i+1, far+1, &diameter2, m);
+        }
+
+        const point *a = vertex(&C, i), *b = vertex(&C, i+1),
+                    *f = vertex(&C, far), *p = vertex(&C, ahead), *q = vertex(&C, behind);
+        double ex = (double)b->x - a->x, ey = (double)b->y - a->y, length = sqrt(ex*ex + ey*ey),
+               ux = ex / length, uy = ey / length,
+               height = ux*((double)f->y - a->y) - uy*((double)f->x - a->x),
+               hi = ux*((double)p->x - a->x) + uy*((double)p->y - a->y),
+               lo = ux*((double)q->x - a->x) + uy*((double)q->y - a->y),
+               area = (hi - lo) * height, perimeter = 2 * (hi - lo + height);
+        if (height < m->width) {
+            m->width = height;
+            m->widthEdge = i;
+            m->widthVertex = far % h;
+        }
+        if (area < bestArea) {
+            bestArea = area;
+            rectangle(&C, i, ux, uy, lo, hi, height, &m->minArea);
+        }
+        if (perimeter < bestPerimeter) {
+            bestPerimeter = perimeter;
+            rectangle(&C, i, ux, uy, lo, hi, height, &m->minPerimeter);
+        }
+    }
+    m->diameter = sqrt(diameter2);
+}
+
+struct calipersBatch {
+    const point *Points;
+    const int *starts, *out, *hullStarts;
+    struct hullMeasures *m;
+};
+
+static void measureSets(void *context, int first, int end) {
+    const struct calipersBatch *B = context;
+    for (int s=first; s<end; s++)
+        hullCalipers(&B->Points[B->starts[s]], &B->out[B->hullStarts[s]],
+                     B->hullStarts[s+1] - B->hullStarts[s], &B->m[s]);
+}
+
+/**
+ * Computes the measures of many hulls, as returned by convexHullBatch(),
+ * with a few threads that claim blocks of sets like convexHullBatch() does.
+ * @param  Points     All point sets, one after the other (sorted by
+ *                    convexHullBatch())
+ * @param  starts     Set s is Points[starts[s]..starts[s+1]-1]
+ * @param  out        The hulls, indices into their sets
+ * @param  hullStarts The hull of set s is out[hullStarts[s]..hullStarts[s+1]-1]
+ * @param  sets       Number of sets
+ * @param  m          Receives the measures of each set (all 0 if it is empty)
+ * @param  threads    Number of threads to use
+ */
+void hullCalipersBatch(const point *Points, const int *starts, const int *out,
+                       const int *hullStarts, int sets, struct hullMeasures *m, int threads) {
+    struct calipersBatch B = { Points, starts, out, hullStarts, m };
+    convexHullBatchRun(sets, threads, measureSets, &B);
+}
+
+/**
+ * Lists the antipodal pairs of a convex hull, the pairs of vertices through
+ * which there are two parallel supporting lines, in O(h) time.
+ * Vertex i+1 is antipodal to the vertices from the first one farthest from
+ * edge i to the last one farthest from edge i+1, and every pair is listed
+ * from its smaller vertex.
+ * @param  Points A set of points (in the plane)
+ * @param  hull   Indices into Points of the vertices of CH(P) in the order
+ *                of convexHullIndices()
+ * @param  h      Number of vertices
+ * @param  pairs  Receives the pairs of vertices (positions in hull), two
+ *                after the other; room for 3*h
+ * @return        Number of pairs
+ */
+int hullAntipodalPairs(const point *Points, const int *hull, int h, int *pairs) {
+    struct calipers C = { Points, hull, h };
+    if (h <= 1) return 0;
+    if (h == 2) {
+        pairs[0] = 0;
+        pairs[1] = 1;
+        return 1;
+    }
+    int count = 0, first = 1;
+    while (first < h && edgeCross(&C, 0, first) > 0)
+        first++;
+    for (int i=0; i<h; i++) {
+        // The first and the last vertex farthest from edge i+1
+        int next = max(first, i+2);
+        while (next < i+1+h && edgeCross(&C, i+1, next) > 0)
+            next++;
+        int last = next + (edgeCross(&C, i+1, next) == 0);
+        for (int v=first; v<=last; v++) {
+            if ((i+1) % h < v % h) {
+                pairs[2*count] = (i+1) % h;
+                pairs[2*count+1] = v % h;
+                count++;
+            }
+        }
+        first = next;
+    }
+    return count;
+}
+
+
+/**
+ * [FS75]
+ *     Herbert Freeman and Ruth Shapira, "Determining the minimum-area
+ *     encasing rectangle for an arbitrary closed curve", Communications of
+ *     the ACM 18 (1975)
+ *
+ * [Tou83]
+ *     Godfried Toussaint, "Solving geometric problems with the rotating
+ *     calipers", Proceedings of IEEE MELECON (1983)
+ */
@@ -0,0 +1,39 @@
+#ifndef __calipers_h
+#define __calipers_h
+
+#include "convexhull.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A rectangle around a hull with one side on the line of a hull edge
+struct hullRectangle {
+    double x[4], y[4];    // corners, in the order of the hull
+    double width, height; // along the edge and across it
+    int edge;             // the edge from vertex edge to edge+1 of the hull
+};
+
+/**
+ * Measures of a convex hull from one sweep of rotating calipers. Vertices
+ * and edges are positions in the hull, i.e. hull[vertex] is the point.
+ */
+struct hullMeasures {
+    double diameter;        // largest distance of two vertices
+    int diameterPair[2];
+    double width;           // smallest distance of two parallel supporting lines
+    int widthEdge;          // one line is on this edge (from vertex widthEdge
+    int widthVertex;        // to widthEdge+1), the other at this vertex
+    struct hullRectangle minArea, minPerimeter;
+};
+
+void hullCalipers(const point *Points, const int *hull, int h, struct hullMeasures *m);
+void hullCalipersBatch(const point *Points, const int *starts, const int *out,
+                       const int *hullStarts, int sets, struct hullMeasures *m, int threads);
+int hullAntipodalPairs(const point *Points, const int *hull, int h, int *pairs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __calipers_h */
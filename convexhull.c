@@ -1,5 +1,47 @@
+#ifdef CH_TIMING
+#define _POSIX_C_SOURCE 200112L // clock_gettime
+#include <time.h>
+#endif
 #include "convexhull.h"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
+// All list memory of one convexHull() call is a single block: the list head
+// followed by its entries. Thus convexHullFree() is one call to free().
+struct hullArena {
+    struct circleq head;
+    struct entry entries[];
+};
+
+/*
+ * Phase timings:
+ * Compiled with CH_TIMING, convexHull(), convexHullIndices() and
+ * convexHullParallel() record the time of their phases (sorting, the
+ * monotone chain, and merging slabs or building the list) in
+ * convexHullTimings, and convexHullWith() in the timings of its context.
+ * Without it the macros compile to nothing.
+ */
+#ifdef CH_TIMING
+struct hullTimings convexHullTimings;
+static double timingNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+#define TIMING_START(t) double t = timingNow()
+#define TIMING_PHASE_TO(timings, phase, t) do {           \
+    double now_ = timingNow();                            \
+    (timings).phase = now_ - (t);                         \
+    (t) = now_;                                           \
+} while (0)
+#else
+#define TIMING_START(t)
+#define TIMING_PHASE_TO(timings, phase, t) do {} while (0)
+#endif
+#define TIMING_PHASE(phase, t) TIMING_PHASE_TO(convexHullTimings, phase, t)
+
+#ifndef CH_HEADLESS
 #define WINDOW_TITLE "Convex Hull Implementation"
 #define POINT_SIZE 5
 #define NUMBER_OF_POINTS 100
@@ -11,12 +53,6 @@ SDL_Surface *screen = NULL;
 SDL_Event event;
 SDL_Renderer *renderer;
 
-CIRCLEQ_HEAD(circleq, entry);
-struct entry {
-    SDL_Rect *rect;
-    CIRCLEQ_ENTRY(entry) entries;
-} *p, *q;
-
 void drawPre(SDL_Renderer *renderer) {
     // Clear screen
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE); // white
@@ -28,31 +64,88 @@ void drawPost(SDL_Renderer *renderer) {
     SDL_RenderPresent(renderer);
 }
 
-void drawPoints(SDL_Renderer *renderer, SDL_Rect *points, int n) {
-    // Draw points
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE); // black
-    SDL_RenderFillRects(renderer, points, n);
+// More points than this are drawn as single pixels, shaded by density
+#define DENSE_POINTS 100000
+
+/**
+ * Splats points into a streaming texture (ARGB8888) of the window size, once
+ * for all frames. Few points are drawn as squares of POINT_SIZE, many as
+ * single pixels, darker with the number of points on them (on a log scale).
+ * @param texture Texture of width x height pixels
+ * @param points  The points, at their top left corners
+ * @param n       Number of points
+ */
+void splatPoints(SDL_Texture *texture, const point *points, int n, int width, int height) {
+    uint32_t *count = calloc((size_t)width * height, sizeof(uint32_t)), most = 0;
+    void *pixels;
+    int pitch, size = (n > DENSE_POINTS ? 1 : POINT_SIZE);
+    if (count == NULL || SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0) {
+        free(count);
+        return;
+    }
+    for (int i=0; i<n && size==1; i++) {
+        if ((unsigned)points[i].x < (unsigned)width && (unsigned)points[i].y < (unsigned)height)
+            count[(size_t)points[i].y*width + points[i].x]++;
+    }
+    for (int i=0; i<n && size>1; i++) {
+        for (int y=max(points[i].y, 0); y<min(points[i].y + size, height); y++)
+            for (int x=max(points[i].x, 0); x<min(points[i].x + size, width); x++)
+                count[(size_t)y*width + x]++;
+    }
+    for (size_t i=0; i<(size_t)width*height; i++)
+        most = max(most, count[i]);
+    double scale = (most > 1 ? 224 / log(most) : 0);
+    for (int y=0; y<height; y++) {
+        uint32_t *row = (uint32_t *)((char *)pixels + (size_t)y*pitch);
+        for (int x=0; x<width; x++) {
+            uint32_t c = count[(size_t)y*width + x],
+                     shade = (c == 0 ? 255 : size > 1 ? 0 : 224 - (int)(log(c) * scale));
+            row[x] = 0xFF000000u | shade * 0x010101u;
+        }
+    }
+    SDL_UnlockTexture(texture);
+    free(count);
+}
+
+void drawPoints(SDL_Renderer *renderer, SDL_Texture *points) {
+    SDL_RenderCopy(renderer, points, NULL, NULL);
 }
 
 void drawConvexHull(SDL_Renderer *renderer, struct circleq *chull) {
-    // Draw lines
+    // Distinguish convex-hull-defining points, and draw the closed chain of
+    // their centers, each with a single call
+    struct entry *e;
+    int h = 0;
+    CIRCLEQ_FOREACH(e, chull, entries)
+        h++;
+    SDL_Rect *vertices = malloc(h * sizeof(SDL_Rect));
+    SDL_Point *lines = malloc((h+1) * sizeof(SDL_Point));
+    if (vertices == NULL || lines == NULL) {
+        free(vertices);
+        free(lines);
+        return;
+    }
+    h = 0;
+    CIRCLEQ_FOREACH(e, chull, entries) {
+        vertices[h] = *e->rect;
+        lines[h].x = e->rect->x + e->rect->w/2;
+        lines[h].y = e->rect->y + e->rect->h/2;
+        h++;
+    }
+    lines[h] = lines[0];
     SDL_SetRenderDrawColor(renderer, 255, 0, 0, SDL_ALPHA_OPAQUE); // red
-    SDL_Rect *u, *v;
-    for (p=chull->cqh_first; p->entries.cqe_next!=(void*)chull; p=p->entries.cqe_next) {
-        u = p->rect;
-        // Distinguish convex-hull-defining points
-        SDL_RenderFillRect(renderer, u);
-        v = p->entries.cqe_next->rect;
-        SDL_RenderDrawLine(renderer,
-            u->x+u->w/2, u->y+u->h/2,
-            v->x+v->w/2, v->y+v->h/2);
-    }
-    // Draw line between head and tail
-    u = chull->cqh_first->rect;
-    v = chull->cqh_last->rect;
-    SDL_RenderDrawLine(renderer,
-        u->x+u->w/2, u->y+u->h/2,
-        v->x+v->w/2, v->y+v->h/2);
+    SDL_RenderFillRects(renderer, vertices, h);
+    SDL_RenderDrawLines(renderer, lines, h+1);
+    free(vertices);
+    free(lines);
+}
+
+// Draws a frame, the points are a texture from splatPoints()
+void drawFrame(SDL_Renderer *renderer, SDL_Texture *points, struct circleq *chull) {
+    drawPre(renderer);
+    drawPoints(renderer, points);
+    drawConvexHull(renderer, chull);
+    drawPost(renderer);
 }
 
 void printUsage(void) {
@@ -96,26 +189,28 @@ int main(int argc, char **argv) {
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
     // Create points
-    // http://stackoverflow.com/questions/5837572/generate-a-random-point-within-a-circle-uniformly
     SDL_Rect *points = calloc(number_of_points, sizeof(SDL_Rect));
-    double t, r;
+    randomDiskPoints(points, number_of_points,
+        WINDOW_WIDTH/2, WINDOW_HEIGHT/2, circle_radius);
     for (int i=0; i<number_of_points; i++) {
-        r = circle_radius * sqrt( ((double)rand()/(double)RAND_MAX) );
-        t = 2 * 3.14159265 * ((double)rand() / (double)RAND_MAX);
-        points[i].x = WINDOW_WIDTH/2 + r * cos(t);
-        points[i].y = WINDOW_HEIGHT/2 + r * sin(t);
         points[i].w = POINT_SIZE;
         points[i].h = POINT_SIZE;
     }
 
-    // Convex hull
-    struct circleq *chull = convexHull(points, number_of_points);
+    // Convex hull (interior points are discarded first)
+    int candidates = convexHullPrefilter(points, number_of_points);
+    printf("Prefilter kept %d of %d points\n", candidates, number_of_points);
+    struct circleq *chull = convexHull(points, candidates);
 
-    // Draw everything once
-    drawPre(renderer);
-    drawPoints(renderer, points, number_of_points);
-    drawConvexHull(renderer, chull);
-    drawPost(renderer);
+    // Upload the points once, then draw a frame whenever it is needed
+    Uint32 start = SDL_GetTicks();
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING, WINDOW_WIDTH, WINDOW_HEIGHT);
+    splatPoints(texture, points, number_of_points, WINDOW_WIDTH, WINDOW_HEIGHT);
+    Uint32 splatted = SDL_GetTicks();
+    drawFrame(renderer, texture, chull);
+    printf("Splatted points in %u ms, drew a frame in %u ms\n",
+           splatted - start, SDL_GetTicks() - splatted);
 
     // Main loop
     int quit = false;
@@ -125,114 +220,1153 @@ int main(int argc, char **argv) {
             case SDL_QUIT:
                 quit = true;
                 break;
+            case SDL_WINDOWEVENT:
+                if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
+                    drawFrame(renderer, texture, chull);
+                break;
         }
     }
 
     // Quit and free resources
-    // TODO: free lists too
+    convexHullFree(chull);
     free(points);
+    SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
     return 0;
 }
+#endif /* CH_HEADLESS */
 
 
+/**
+ * Creates points uniformly distributed in a disk.
+ * http://stackoverflow.com/questions/5837572/generate-a-random-point-within-a-circle-uniformly
+ * @param Points Receives the points (only x and y are set)
+ * @param n      Number of points
+ * @param cx     x coordinate of the center
+ * @param cy     y coordinate of the center
+ * @param radius Radius of the disk
+ */
+void randomDiskPoints(point *Points, int n, int cx, int cy, int radius) {
+    double t, r;
+    for (int i=0; i<n; i++) {
+        r = radius * sqrt( ((double)rand()/(double)RAND_MAX) );
+        t = 2 * 3.14159265 * ((double)rand() / (double)RAND_MAX);
+        Points[i].x = cx + r * cos(t);
+        Points[i].y = cy + r * sin(t);
+    }
+}
+
 // Compares elements with (x,y) coordinates, ordering lexicographicaly
 // https://en.wikipedia.org/wiki/Graham_scan#Pseudocode
+int comparePoints(const point *p, const point *q) {
+    if (p->x != q->x) return (p->x > q->x) - (p->x < q->x);
+    else              return (p->y > q->y) - (p->y < q->y);
+}
 static int cmp(const void *a, const void *b) {
-    const SDL_Rect *p = a, *q = b;
-    if (p->x == q->x) return (p->y) > (q->y);
-    else              return (p->x) > (q->x);
+    return comparePoints(a, b);
+}
+
+/*
+ * Radix sort:
+ * The lexicographic order of (x,y) is the order of the 64 bit unsigned key
+ * with the biased x in the upper and the biased y in the lower half. The
+ * points are sorted by an LSD radix sort on that key, one byte per pass.
+ * Passes where all points have the same byte are skipped, which usually
+ * leaves 4 passes or less for screen-sized coordinates.
+ */
+#define RADIX_MIN_POINTS 256        // use qsort below this
+
+static inline uint64_t radixKey(const point *p) {
+    return ((uint64_t)((uint32_t)p->x ^ 0x80000000u) << 32)
+         | (uint32_t)((uint32_t)p->y ^ 0x80000000u);
+}
+
+/**
+ * Sorts Points lexicographically in O(n) time.
+ * @param  Points A set of points (in the plane)
+ * @param  n      Number of points in Points
+ * @param  tmp    Scratch space for n points; qsort is used if it is NULL
+ */
+void sortPoints(point *Points, int n, point *tmp) {
+    if (tmp == NULL || n < RADIX_MIN_POINTS) {
+        qsort(Points, n, sizeof(point), cmp);
+        return;
+    }
+    // Histograms for all passes in one go
+    static const int passes = sizeof(uint64_t);
+    int counts[sizeof(uint64_t)][256];
+    memset(counts, 0, sizeof(counts));
+    for (int i=0; i<n; i++) {
+        uint64_t key = radixKey(&Points[i]);
+        for (int d=0; d<passes; d++)
+            counts[d][(key >> (8*d)) & 0xff]++;
+    }
+    point *src = Points, *dst = tmp;
+    for (int d=0; d<passes; d++) {
+        int *count = counts[d];
+        if (count[(radixKey(&src[0]) >> (8*d)) & 0xff] == n)
+            continue; // every point has the same digit
+        int offset = 0;
+        for (int b=0; b<256; b++) {
+            int c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (int i=0; i<n; i++)
+            dst[count[(radixKey(&src[i]) >> (8*d)) & 0xff]++] = src[i];
+        point *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != Points)
+        memcpy(Points, src, n*sizeof(point));
+}
+
+/**
+ * Sign of the cross product ux*vy - uy*vx of two vectors given by
+ * differences of int coordinates. It is exact in 64 bit integers as long as
+ * the differences fit in 31 bits, and otherwise left to the robust
+ * orient2d() (differences of ints are exact in double).
+ */
+#define FITS31(d) ((d) > -2147483648LL && (d) < 2147483648LL)
+int crossSign(long long ux, long long uy, long long vx, long long vy) {
+    if (FITS31(ux) && FITS31(uy) && FITS31(vx) && FITS31(vy)) {
+        long long det = ux*vy - uy*vx;
+        return (det > 0) - (det < 0);
+    }
+    double u[2] = {ux, uy}, v[2] = {vx, vy}, o[2] = {0, 0},
+           det = orient2d(u, v, o);
+    return (det > 0) - (det < 0);
 }
 
 /**
  * Three points are a counter-clockwise turn if ccw > 0, clockwise if
- * ccw < 0, and collinear if ccw = 0 because ccw is a determinant that
- * gives twice the signed  area of the triangle formed by p1, p2 and p3.
+ * ccw < 0, and collinear if ccw = 0 because ccw is the sign of a determinant
+ * that gives twice the signed  area of the triangle formed by p1, p2 and p3.
  */
-int ccw(struct circleq *head) {
-    struct entry *p3 = head->cqh_last,
-                 *p2 = p3->entries.cqe_prev,
-                 *p1 = p2->entries.cqe_prev;
-    return (p2->rect->x - p1->rect->x)*(p3->rect->y - p1->rect->y)
-         - (p2->rect->y - p1->rect->y)*(p3->rect->x - p1->rect->x);
+int ccw(const point *p1, const point *p2, const point *p3) {
+    return crossSign((long long)p2->x - p1->x, (long long)p2->y - p1->y,
+                     (long long)p3->x - p1->x, (long long)p3->y - p1->y);
+}
+int makeRightTurn(const point *p1, const point *p2, const point *p3) {
+    return ccw(p1, p2, p3) > 0;
 }
-int lastThreeMakeRightTurn(struct circleq *head) {
-    return ccw(head) > 0;
+
+/**
+ * Pushes Points[i] onto the stack out (of size k), after popping the points
+ * that no longer make a right turn. The bottom base+1 entries are kept.
+ * @return new size of the stack
+ */
+static int pushVertex(const point *Points, int *out, int k, int base, int i) {
+    while (k>base+1 && !makeRightTurn(&Points[out[k-2]], &Points[out[k-1]], &Points[i]))
+        k--;
+    out[k++] = i;
+    return k;
 }
 
+/**
+ * Computes the convex hull [CH()] of lexicographically sorted points.
+ * The array out is used as a stack while building the upper and lower part,
+ * so it must have room for n+1 indices (at most n are in use at the end).
+ * The upper part ends with index n-1, where the lower part takes over.
+ * @param  Points A set of points (in the plane), sorted lexicographically
+ * @param  n      Number of points in Points
+ * @param  out    Receives the indices of the vertices of CH(P) in clockwise order
+ * @return        Number of vertices of CH(P) written to out
+ */
+int convexHullSorted(const point *Points, int n, int *out) {
+    int k = 0;
+    if (n <= 0) return 0;
+
+    // Upper part
+    for (int i=0; i<n; i++)
+        k = pushVertex(Points, out, k, 0, i);
+    // Lower part (continues from the last point of the upper part)
+    int upperSize = k;
+    for (int i=n-2; i>=0; i--)
+        k = pushVertex(Points, out, k, upperSize-1, i);
+    // Points[0] is pushed again as the last point, but already starts the hull
+    return (n > 1 ? k-1 : k);
+}
+
+/**
+ * Computes the convex hull [CH()] without any heap allocations.
+ * NB: Points are sorted lexicographically in place, like convexHull() does,
+ * but with qsort as there is no scratch space for sortPoints().
+ * @param  Points A set of points (in the plane)
+ * @param  n      Number of points in Points
+ * @param  out    Receives the indices (into the sorted Points) of the
+ *                vertices of CH(P) in clockwise order; room for n+1 indices
+ * @return        Number of vertices of CH(P) written to out
+ */
+int convexHullIndices(point *Points, int n, int *out) {
+    if (n <= 0) return 0;
+    TIMING_START(t);
+    qsort(Points, n, sizeof(point), cmp);
+    TIMING_PHASE(sort, t);
+    int h = convexHullSorted(Points, n, out);
+    TIMING_PHASE(chain, t);
+    TIMING_PHASE(merge, t);
+    return h;
+}
+
+static void *defaultAlloc(void *user, size_t size) {
+    (void)user;
+    return malloc(size);
+}
+
+static void defaultRelease(void *user, void *block) {
+    (void)user;
+    free(block);
+}
+
+/**
+ * Prepares a context for convexHullWith(): malloc() and free(), no logging
+ * and no scratch space yet. Members may be set afterwards.
+ */
+void convexHullContextInit(struct hullContext *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->alloc = defaultAlloc;
+    ctx->release = defaultRelease;
+}
+
+/**
+ * Releases the scratch space of a context (not the lists made with it).
+ */
+void convexHullContextFree(struct hullContext *ctx) {
+    ctx->release(ctx->user, ctx->hull);
+    ctx->release(ctx->user, ctx->tmp);
+    ctx->hull = NULL;
+    ctx->tmp = NULL;
+    ctx->capacity = 0;
+}
+
+// Formats a message for the logging hook of ctx, if there is one
+static void logMessage(const struct hullContext *ctx, const char *format, ...) {
+    if (ctx->log == NULL) return;
+    char message[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    ctx->log(ctx->user, message);
+}
+
+// Grows the scratch space of ctx to n points, returns false if out of memory
+static int reserveScratch(struct hullContext *ctx, int n) {
+    if ((size_t)n <= ctx->capacity) return true;
+    convexHullContextFree(ctx);
+    ctx->hull = ctx->alloc(ctx->user, ((size_t)n+1)*sizeof(int));
+    ctx->tmp = ctx->alloc(ctx->user, (size_t)n*sizeof(point));
+    if (ctx->hull == NULL || ctx->tmp == NULL) {
+        convexHullContextFree(ctx);
+        return false;
+    }
+    ctx->capacity = n;
+    return true;
+}
+
+/**
+ * Computes the convex hull [CH()] like convexHull(), but reentrant: all
+ * state is in the context, which is owned by the caller, so calls with
+ * different contexts may run concurrently. The scratch space is kept in the
+ * context and reused by later calls.
+ * @param  ctx    Context from convexHullContextInit()
+ * @param  Points A set of points (in the plane), sorted in place
+ * @param  n      Number of points in Points
+ * @return        A list containing the vertices of CH(P) in clockwise order,
+ *                allocated by ctx and released with convexHullFreeWith(),
+ *                or NULL if out of memory
+ */
+struct circleq *convexHullWith(struct hullContext *ctx, point *Points, int n) {
+    logMessage(ctx, "convexHull(points, %d):", n);
+    TIMING_START(t);
+    if (!reserveScratch(ctx, max(n, 1))) return NULL;
+    sortPoints(Points, n, ctx->tmp);
+    TIMING_PHASE_TO(ctx->timings, sort, t);
+    int h = convexHullSorted(Points, n, ctx->hull);
+    TIMING_PHASE_TO(ctx->timings, chain, t);
+
+    struct hullArena *arena = ctx->alloc(ctx->user,
+                                         sizeof(struct hullArena) + h*sizeof(struct entry));
+    if (arena == NULL) return NULL;
+    struct circleq *chull = &arena->head;
+    CIRCLEQ_INIT(chull);
+    for (int i=0; i<h; i++) {
+        struct entry *e = &arena->entries[i];
+        e->rect = &Points[ctx->hull[i]];
+        CIRCLEQ_INSERT_TAIL(chull, e, entries);
+    }
+    TIMING_PHASE_TO(ctx->timings, merge, t);
+    logMessage(ctx, "Done: Convex Hull computed.");
+    return chull;
+}
+
+/**
+ * Releases a list returned by convexHullWith() with the same context.
+ */
+void convexHullFreeWith(struct hullContext *ctx, struct circleq *chull) {
+    // The head is the first member of the arena holding the entries
+    ctx->release(ctx->user, chull);
+}
+
+#ifndef CH_HEADLESS
+static void printMessage(void *user, const char *message) {
+    (void)user;
+    printf("%s\n", message);
+}
+#endif
+
 /**
  * Computes the convex hull [CH()].
  * Implementation based on algorithm from Chapter 1, page 6 [CompGeo08]
+ * Not reentrant with CH_TIMING (see convexHullWith()).
  * @param  Points A set of points (in the plane)
  * @param  n      Number of points in Points
- * @return        A list containing the vertices of CH(P) in clockwise order
+ * @return        A list containing the vertices of CH(P) in clockwise order,
+ *                to be released with convexHullFree()
  */
-struct circleq *convexHull(SDL_Rect *Points, int n) {
-    printf("convexHull(points, %d):\n", n);
-    int listSize = 0;
-    qsort(Points, n, sizeof(SDL_Rect), cmp);
+struct circleq *convexHull(point *Points, int n) {
+    struct hullContext ctx;
+    convexHullContextInit(&ctx);
+#ifndef CH_HEADLESS
+    ctx.log = printMessage;
+#endif
+    struct circleq *chull = convexHullWith(&ctx, Points, n);
+#ifdef CH_TIMING
+    convexHullTimings = ctx.timings;
+#endif
+    convexHullContextFree(&ctx);
+    return chull;
+}
 
-    // Upper part
-    CIRCLEQ_NEW(circleq, Lupper);
-    CIRCLEQ_INIT(Lupper);
-    p = malloc(sizeof(struct entry));
-    q = malloc(sizeof(struct entry));
-    p->rect = &Points[0];
-    q->rect = &Points[1];
-    CIRCLEQ_INSERT_HEAD(Lupper, p, entries);
-    CIRCLEQ_INSERT_TAIL(Lupper, q, entries);
-    listSize = 2;
-    for (int i=2; i<n; i++) {
-        p = malloc(sizeof(struct entry));
-        p->rect = &Points[i];
-        CIRCLEQ_INSERT_TAIL(Lupper, p, entries);
-        listSize++;
-        while (listSize>2 && !lastThreeMakeRightTurn(Lupper)) {
-            q = Lupper->cqh_last->entries.cqe_prev; // next to last element
-            CIRCLEQ_REMOVE(Lupper, q, entries);
-            listSize--;
-        }
-    }
-    // Lower part
-    CIRCLEQ_NEW(circleq, Lower);
-    CIRCLEQ_INIT(Lower);
-    p = malloc(sizeof(struct entry));
-    q = malloc(sizeof(struct entry));
-    p->rect = &Points[n-1];
-    q->rect = &Points[n-2];
-    CIRCLEQ_INSERT_HEAD(Lower, p, entries);
-    CIRCLEQ_INSERT_TAIL(Lower, q, entries);
-    listSize = 2;
-    for (int i=n-3; i>=0; i--) {
-        p = malloc(sizeof(struct entry));
-        p->rect = &Points[i];
-        CIRCLEQ_INSERT_TAIL(Lower, p, entries);
-        listSize++;
-        while (listSize>2 && !lastThreeMakeRightTurn(Lower)) {
-            q = Lower->cqh_last->entries.cqe_prev;
-            CIRCLEQ_REMOVE(Lower, q, entries);
-            listSize--;
-        }
-    }
-    // NB: inserting expressions for p and q in CIRCLEQ_REMOVE leads to serious problems
-    p = Lower->cqh_first;
-    CIRCLEQ_REMOVE(Lower, p, entries);
-    q = Lower->cqh_last;
-    CIRCLEQ_REMOVE(Lower, q, entries);
-    // Ugly list-merge (manual merges hangs the program? :/)
-    CIRCLEQ_FOREACH_SAFE(p, Lower, entries, q) {
-        CIRCLEQ_INSERT_TAIL(Lupper, p, entries);
-    }
-
-    printf("Done: Convex Hull computed.\n");
-    return Lupper;
+/**
+ * Releases a list returned by convexHull(), including all of its entries.
+ */
+void convexHullFree(struct circleq *chull) {
+    // The head is the first member of the arena holding the entries
+    free(chull);
 }
 
 
+/*
+ * Akl-Toussaint prefilter:
+ * The extreme points in 8 directions span an octagon inside CH(P), and no
+ * point strictly inside it can be a vertex of CH(P). The orientation tests
+ * against the octagon edges run in batches over a structure-of-arrays copy
+ * of a block of points, using AVX2 or SSE2 when compiled with support.
+ * They are evaluated in double precision with the error bound of orient2d(),
+ * so a point is only discarded when it is certainly inside.
+ */
+#define PREFILTER_BLOCK 256
+#define PREFILTER_ERRBOUND CCW_ERRBOUND_A
+
+struct octagonEdge {
+    double ax, ay, dx, dy; // start point and direction
+};
+
+// Sets inside[i] if (xs[i],ys[i]) is strictly left of every edge
+static void insideOctagon(const double *xs, const double *ys, int m,
+                          const struct octagonEdge *E, int edges,
+                          unsigned char *inside) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256d sign = _mm256_set1_pd(-0.0),
+                  err = _mm256_set1_pd(PREFILTER_ERRBOUND);
+    for (; i+4<=m; i+=4) {
+        __m256d px = _mm256_loadu_pd(&xs[i]),
+                py = _mm256_loadu_pd(&ys[i]),
+                mask = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        for (int e=0; e<edges; e++) {
+            __m256d t1 = _mm256_mul_pd(_mm256_set1_pd(E[e].dx),
+                             _mm256_sub_pd(py, _mm256_set1_pd(E[e].ay))),
+                    t2 = _mm256_mul_pd(_mm256_set1_pd(E[e].dy),
+                             _mm256_sub_pd(px, _mm256_set1_pd(E[e].ax))),
+                    det = _mm256_sub_pd(t1, t2),
+                    bound = _mm256_mul_pd(err, _mm256_add_pd(
+                        _mm256_andnot_pd(sign, t1), _mm256_andnot_pd(sign, t2)));
+            mask = _mm256_and_pd(mask, _mm256_cmp_pd(det, bound, _CMP_GT_OQ));
+        }
+        int bits = _mm256_movemask_pd(mask);
+        for (int j=0; j<4; j++)
+            inside[i+j] = (bits >> j) & 1;
+    }
+#elif defined(__SSE2__)
+    const __m128d sign = _mm_set1_pd(-0.0),
+                  err = _mm_set1_pd(PREFILTER_ERRBOUND);
+    for (; i+2<=m; i+=2) {
+        __m128d px = _mm_loadu_pd(&xs[i]),
+                py = _mm_loadu_pd(&ys[i]),
+                mask = _mm_castsi128_pd(_mm_set1_epi32(-1));
+        for (int e=0; e<edges; e++) {
+            __m128d t1 = _mm_mul_pd(_mm_set1_pd(E[e].dx),
+                             _mm_sub_pd(py, _mm_set1_pd(E[e].ay))),
+                    t2 = _mm_mul_pd(_mm_set1_pd(E[e].dy),
+                             _mm_sub_pd(px, _mm_set1_pd(E[e].ax))),
+                    det = _mm_sub_pd(t1, t2),
+                    bound = _mm_mul_pd(err, _mm_add_pd(
+                        _mm_andnot_pd(sign, t1), _mm_andnot_pd(sign, t2)));
+            mask = _mm_and_pd(mask, _mm_cmpgt_pd(det, bound));
+        }
+        int bits = _mm_movemask_pd(mask);
+        inside[i] = bits & 1;
+        inside[i+1] = (bits >> 1) & 1;
+    }
+#endif
+    // Remaining points (all of them without SIMD support)
+    for (; i<m; i++) {
+        int in = 1;
+        for (int e=0; e<edges; e++) {
+            double t1 = E[e].dx * (ys[i] - E[e].ay),
+                   t2 = E[e].dy * (xs[i] - E[e].ax);
+            in &= (t1 - t2 > PREFILTER_ERRBOUND * (fabs(t1) + fabs(t2)));
+        }
+        inside[i] = in;
+    }
+}
+
+/**
+ * Discards points that cannot be vertices of the convex hull [CH()], using
+ * the Akl-Toussaint heuristic. The remaining points are moved to the front
+ * of Points (the discarded ones are kept behind them, in no particular order)
+ * such that CH(P) can be computed from the first m points only.
+ * @param  Points A set of points (in the plane)
+ * @param  n      Number of points in Points
+ * @return        Number m of points that may be vertices of CH(P)
+ */
+int convexHullPrefilter(point *Points, int n) {
+    if (n < 8) return n;
+
+    // Extreme points in 8 directions, in counter-clockwise order (y upwards)
+    int ext[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int i=1; i<n; i++) {
+        long long x = Points[i].x, y = Points[i].y;
+        if (y < Points[ext[0]].y) ext[0] = i;                                        // S
+        if (x-y > (long long)Points[ext[1]].x - Points[ext[1]].y) ext[1] = i;      // SE
+        if (x > Points[ext[2]].x) ext[2] = i;                                        // E
+        if (x+y > (long long)Points[ext[3]].x + Points[ext[3]].y) ext[3] = i;      // NE
+        if (y > Points[ext[4]].y) ext[4] = i;                                        // N
+        if (x-y < (long long)Points[ext[5]].x - Points[ext[5]].y) ext[5] = i;      // NW
+        if (x < Points[ext[6]].x) ext[6] = i;                                        // W
+        if (x+y < (long long)Points[ext[7]].x + Points[ext[7]].y) ext[7] = i;      // SW
+    }
+    // Octagon edges, skipping repeated corners
+    point corner[8];
+    int corners = 0;
+    for (int d=0; d<8; d++) {
+        point c = Points[ext[d]];
+        if (corners == 0 || c.x != corner[corners-1].x || c.y != corner[corners-1].y)
+            corner[corners++] = c;
+    }
+    while (corners > 1 && corner[0].x == corner[corners-1].x && corner[0].y == corner[corners-1].y)
+        corners--;
+    if (corners < 3) return n;
+    struct octagonEdge E[8];
+    for (int e=0; e<corners; e++) {
+        point a = corner[e], b = corner[(e+1) % corners];
+        E[e] = (struct octagonEdge) { .ax = a.x, .ay = a.y,
+            .dx = (double)b.x - a.x, .dy = (double)b.y - a.y };
+    }
+
+    // Filter block by block, moving the kept points to the front
+    double xs[PREFILTER_BLOCK], ys[PREFILTER_BLOCK];
+    unsigned char inside[PREFILTER_BLOCK];
+    int m = 0;
+    for (int start=0; start<n; start+=PREFILTER_BLOCK) {
+        int size = min(PREFILTER_BLOCK, n-start);
+        for (int j=0; j<size; j++) {
+            xs[j] = Points[start+j].x;
+            ys[j] = Points[start+j].y;
+        }
+        insideOctagon(xs, ys, size, E, corners, inside);
+        for (int j=0; j<size; j++) {
+            if (inside[j]) continue;
+            point tmp = Points[m];
+            Points[m++] = Points[start+j];
+            Points[start+j] = tmp;
+        }
+    }
+    return m;
+}
+
+
+/*
+ * Parallel mode:
+ * The points are distributed over P slabs of consecutive lexicographic order
+ * (a sample sort), and each slab is sorted and hulled by a thread of its own.
+ * The sub-hulls are then merged from left to right: pushing the vertices of
+ * the next slab onto the hull computed so far pops exactly the vertices left
+ * of the bridge (the common tangent), so merging is linear in the sub-hulls.
+ */
+#define PARALLEL_MIN_POINTS 16384   // points per thread worth a thread
+#define PARALLEL_MAX_THREADS 256
+#define PARALLEL_SAMPLES 64         // samples per slab for choosing splitters
+
+struct slabShared {
+    point *Points, *tmp;
+    const point *splitters;         // threads-1 points separating the slabs
+    int n, threads;
+    int *counts;    // counts[b*threads+s]: points of block b in slab s
+    int *offsets;   // offsets[b*threads+s]: where block b writes in slab s
+    int *starts;    // slab s is Points[starts[s]..starts[s+1]-1]
+    int *chains;    // hull of slab s is chains[starts[s]+s..]
+    int *sizes;     // number of hull vertices of slab s
+};
+struct slabJob {
+    struct slabShared *S;
+    int id;
+};
+
+// Slab of a point: the number of splitters smaller than it
+static int slabOf(struct slabShared *S, const point *x) {
+    int lo = 0, hi = S->threads-1;
+    while (lo < hi) {
+        int mid = (lo+hi)/2;
+        if (cmp(x, &S->splitters[mid]) > 0)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+static int blockStart(struct slabShared *S, int b) {
+    return (int)((long long)S->n * b / S->threads);
+}
+
+static void *slabCountWorker(void *arg) {
+    struct slabJob *job = arg;
+    struct slabShared *S = job->S;
+    int *counts = &S->counts[job->id*S->threads];
+    for (int i=blockStart(S, job->id); i<blockStart(S, job->id+1); i++)
+        counts[slabOf(S, &S->Points[i])]++;
+    return NULL;
+}
+static void *slabScatterWorker(void *arg) {
+    struct slabJob *job = arg;
+    struct slabShared *S = job->S;
+    int *offsets = &S->offsets[job->id*S->threads];
+    for (int i=blockStart(S, job->id); i<blockStart(S, job->id+1); i++)
+        S->tmp[offsets[slabOf(S, &S->Points[i])]++] = S->Points[i];
+    return NULL;
+}
+static void *slabSortWorker(void *arg) {
+    struct slabJob *job = arg;
+    struct slabShared *S = job->S;
+    int start = S->starts[job->id],
+        m = S->starts[job->id+1] - start;
+    memcpy(&S->Points[start], &S->tmp[start], m*sizeof(point));
+    sortPoints(&S->Points[start], m, &S->tmp[start]);
+    return NULL;
+}
+static void *slabChainWorker(void *arg) {
+    struct slabJob *job = arg;
+    struct slabShared *S = job->S;
+    int start = S->starts[job->id],
+        m = S->starts[job->id+1] - start;
+    S->sizes[job->id] = convexHullSorted(&S->Points[start], m, &S->chains[start+job->id]);
+    return NULL;
+}
+
+// Runs worker on each of the jobs (an array of jobs of jobSize bytes), one
+// thread per job (the first on this thread)
+static void runWorkers(void *(*worker)(void *), void *jobs, size_t jobSize, int threads) {
+    pthread_t tids[PARALLEL_MAX_THREADS];
+    int started[PARALLEL_MAX_THREADS];
+    for (int t=1; t<threads; t++) {
+        void *job = (char*)jobs + t*jobSize;
+        started[t] = (pthread_create(&tids[t], NULL, worker, job) == 0);
+        if (!started[t])
+            worker(job);
+    }
+    worker(jobs);
+    for (int t=1; t<threads; t++)
+        if (started[t])
+            pthread_join(tids[t], NULL);
+}
+
+/**
+ * Computes the convex hull [CH()] using several threads.
+ * Same result as convexHullIndices(): Points end up sorted lexicographically
+ * and out receives the indices of the vertices of CH(P) in clockwise order.
+ * Besides a few small arrays it needs a copy of the points while sorting.
+ * @param  Points  A set of points (in the plane)
+ * @param  n       Number of points in Points
+ * @param  out     Receives the indices of the hull; room for n+1 indices
+ * @param  threads Number of threads (and slabs) to use
+ * @return         Number of vertices of CH(P) written to out
+ */
+int convexHullParallel(point *Points, int n, int *out, int threads) {
+    threads = min(threads, min(n / PARALLEL_MIN_POINTS, PARALLEL_MAX_THREADS));
+    if (threads <= 1)
+        return convexHullIndices(Points, n, out);
+
+    TIMING_START(t);
+    struct slabShared S = { .Points = Points, .n = n, .threads = threads };
+    int samples = PARALLEL_SAMPLES*threads;
+    point *sample = malloc(samples*sizeof(point));
+    S.tmp = malloc(n*sizeof(point));
+    S.counts = calloc(threads*threads, sizeof(int));
+    S.offsets = malloc(threads*threads*sizeof(int));
+    S.starts = malloc((threads+1)*sizeof(int));
+    S.chains = malloc((n+threads)*sizeof(int));
+    S.sizes = malloc(threads*sizeof(int));
+    struct slabJob *jobs = malloc(threads*sizeof(struct slabJob));
+    if (!sample || !S.tmp || !S.counts || !S.offsets || !S.starts || !S.chains
+            || !S.sizes || !jobs) {
+        threads = 0;
+        goto cleanup;
+    }
+    for (int t=0; t<threads; t++)
+        jobs[t] = (struct slabJob) { .S = &S, .id = t };
+
+    // Choose splitters from an evenly spaced sample
+    for (int i=0; i<samples; i++)
+        sample[i] = Points[(long long)n * i / samples];
+    qsort(sample, samples, sizeof(point), cmp);
+    for (int s=0; s<threads-1; s++)
+        sample[s] = sample[(s+1)*PARALLEL_SAMPLES];
+    S.splitters = sample;
+
+    // Distribute the points over the slabs
+    runWorkers(slabCountWorker, jobs, sizeof(struct slabJob), threads);
+    S.starts[0] = 0;
+    for (int s=0; s<threads; s++) {
+        int offset = S.starts[s];
+        for (int b=0; b<threads; b++) {
+            S.offsets[b*threads+s] = offset;
+            offset += S.counts[b*threads+s];
+        }
+        S.starts[s+1] = offset;
+    }
+    runWorkers(slabScatterWorker, jobs, sizeof(struct slabJob), threads);
+
+    // Sort and hull each slab
+    runWorkers(slabSortWorker, jobs, sizeof(struct slabJob), threads);
+    TIMING_PHASE(sort, t);
+    runWorkers(slabChainWorker, jobs, sizeof(struct slabJob), threads);
+    TIMING_PHASE(chain, t);
+
+cleanup:;
+    int k = 0;
+    if (threads > 0) {
+        // Merge upper parts from left to right...
+        for (int s=0; s<threads; s++) {
+            int start = S.starts[s],
+                last = S.starts[s+1] - start - 1,
+                *chain = &S.chains[start+s];
+            for (int i=0; i<S.sizes[s]; i++) {
+                k = pushVertex(Points, out, k, 0, start+chain[i]);
+                if (chain[i] == last) break;
+            }
+        }
+        // ... and lower parts from right to left
+        int upperSize = k;
+        for (int s=threads-1; s>=0; s--) {
+            int start = S.starts[s],
+                last = S.starts[s+1] - start - 1,
+                *chain = &S.chains[start+s],
+                i = 0;
+            if (last < 0) continue;
+            while (chain[i] != last)
+                i++;
+            if (start+last < n-1) // the very last point already ends the upper part
+                k = pushVertex(Points, out, k, upperSize-1, start+last);
+            for (i++; i<S.sizes[s]; i++)
+                k = pushVertex(Points, out, k, upperSize-1, start+chain[i]);
+            if (last > 0)
+                k = pushVertex(Points, out, k, upperSize-1, start);
+        }
+        // Points[0] was pushed again as the last point
+        if (n > 1) k--;
+        TIMING_PHASE(merge, t);
+    }
+    free(sample);
+    free(S.tmp);
+    free(S.counts);
+    free(S.offsets);
+    free(S.starts);
+    free(S.chains);
+    free(S.sizes);
+    free(jobs);
+    if (threads == 0)
+        return convexHullIndices(Points, n, out);
+    return k;
+}
+
+
+/*
+ * Chan's algorithm [Chan96]:
+ * The points are split into groups of m points, whose hulls are computed by
+ * the monotone chain. Each part of CH(P) is then wrapped from one end to the
+ * other (as in Jarvis' march), where the next vertex is the best of the
+ * tangents from the current vertex to the same part of every group, each
+ * found by binary search. Wrapping gives up after m steps, and m is squared
+ * until h <= m, which takes O(n log h) time in total. Points that are not on
+ * the hull of their group are dropped before the next round.
+ */
+#define CHAN_FIRST_GROUP 64
+
+struct chanGroups {
+    int groups;
+    int *chains; // both parts of all groups, as indices into Points
+    int *starts; // part p of group g is chains[starts[2*g+p]..starts[2*g+p+1]-1]
+};
+
+/**
+ * Sorts the groups of m points and stores both parts of their hulls, the
+ * first part from left to right and the second from right to left.
+ * @param hull Scratch space for m+1 indices
+ */
+static void chanGroups(point *Points, int n, int m, point *tmp, int *hull,
+                       struct chanGroups *G) {
+    int c = 0;
+    for (int g=0; g<G->groups; g++) {
+        int start = g*m, size = min(m, n-start);
+        sortPoints(&Points[start], size, tmp);
+        int h = convexHullSorted(&Points[start], size, hull), u = 0;
+        while (hull[u] != size-1 && size > 1)
+            u++;
+        G->starts[2*g] = c;
+        for (int i=0; i<=u; i++)
+            G->chains[c++] = start + hull[i];
+        G->starts[2*g+1] = c;
+        for (int i=u; i<h; i++)
+            G->chains[c++] = start + hull[i];
+        G->chains[c++] = start + hull[0];
+    }
+    G->starts[2*G->groups] = c;
+}
+
+/**
+ * Finds the tangent from Points[q] to a part of a group, among the vertices
+ * beyond q: the one that has all others on its left. The vertices beyond q
+ * are a suffix of the part, on which the turn from q changes sign once.
+ * @param  dir 1 if the part goes from left to right, -1 otherwise
+ * @return     The tangent vertex, or -1 if no vertex is beyond q
+ */
+static int chanTangent(const point *Points, const int *part, int len, int dir, int q) {
+    int lo = 0, hi = len;
+    while (lo < hi) {
+        int mid = (lo+hi) / 2;
+        if (dir*cmp(&Points[part[mid]], &Points[q]) > 0) hi = mid;
+        else lo = mid+1;
+    }
+    if (lo == len) return -1;
+    // First vertex from which the part turns away from q (collinear
+    // vertices are skipped to the furthest one)
+    hi = len-1;
+    while (lo < hi) {
+        int mid = (lo+hi) / 2;
+        if (ccw(&Points[q], &Points[part[mid]], &Points[part[mid+1]]) > 0) hi = mid;
+        else lo = mid+1;
+    }
+    return part[lo];
+}
+
+/**
+ * Wraps part p of CH(P) from Points[from] to Points[to] (excluded), writing
+ * the vertices to out from index k on.
+ * @return New number of vertices in out, or -1 after more than limit steps
+ */
+static int chanWrap(const point *Points, const struct chanGroups *G, int p,
+                    int from, int to, int *out, int k, int limit) {
+    int dir = (p == 0 ? 1 : -1), q = from;
+    for (int steps=0; cmp(&Points[q], &Points[to]) != 0; steps++) {
+        if (steps == limit) return -1;
+        out[k++] = q;
+        int best = -1;
+        for (int g=0; g<G->groups; g++) {
+            int s = G->starts[2*g+p],
+                t = chanTangent(Points, &G->chains[s], G->starts[2*g+p+1]-s, dir, q);
+            if (t < 0) continue;
+            int turn = (best < 0 ? -1 : ccw(&Points[q], &Points[best], &Points[t]));
+            if (turn < 0 || (turn == 0 && dir*cmp(&Points[t], &Points[best]) > 0))
+                best = t;
+        }
+        if (best < 0) break;
+        q = best;
+    }
+    return k;
+}
+
+/**
+ * Computes the convex hull [CH()] in O(n log h) time by Chan's algorithm,
+ * which is output-sensitive: faster for small hulls (h << n).
+ * NB: Points are reordered in place (the vertices of CH(P) end up in front).
+ * @param  Points A set of points (in the plane)
+ * @param  n      Number of points in Points
+ * @param  out    Receives the indices (into the reordered Points) of the
+ *                vertices of CH(P) in clockwise order; room for n+1 indices
+ * @return        Number of vertices of CH(P) written to out
+ */
+int convexHullChan(point *Points, int n, int *out) {
+    if (n <= 0) return 0;
+    point *tmp = malloc(n*sizeof(point)); // NULL makes sortPoints use qsort
+    unsigned char *onHull = malloc(n);
+    int k = -1, all = n;
+    for (long long mm = CHAN_FIRST_GROUP; k < 0 && onHull != NULL; mm *= mm) {
+        int m = (mm < n ? (int)mm : n);
+        struct chanGroups G;
+        G.groups = (n + m - 1) / m;
+        G.chains = malloc((n + 2*G.groups) * sizeof(int));
+        G.starts = malloc((2*G.groups + 1) * sizeof(int));
+        int *hull = malloc((m+1) * sizeof(int));
+        if (G.chains == NULL || G.starts == NULL || hull == NULL) {
+            free(G.chains);
+            free(G.starts);
+            free(hull);
+            break;
+        }
+        chanGroups(Points, n, m, tmp, hull, &G);
+
+        // The ends of both parts are the ends of some groups
+        int first = 0, last = n-1;
+        for (int g=0; g<G.groups; g++) {
+            int start = G.chains[G.starts[2*g]],
+                end = G.chains[G.starts[2*g+1]-1];
+            if (cmp(&Points[start], &Points[first]) < 0) first = start;
+            if (cmp(&Points[end], &Points[last]) > 0) last = end;
+        }
+        if (cmp(&Points[first], &Points[last]) == 0) {
+            // All points are equal (reported twice, like convexHullSorted())
+            out[0] = first;
+            out[1] = last;
+            k = (n > 1 ? 2 : 1);
+        } else {
+            k = chanWrap(Points, &G, 0, first, last, out, 0, m);
+            if (k >= 0)
+                k = chanWrap(Points, &G, 1, last, first, out, k, m);
+        }
+        if (k < 0) {
+            // Only the vertices of the group hulls remain for the next round
+            memset(onHull, 0, n);
+            for (int i=0; i<G.starts[2*G.groups]; i++)
+                onHull[G.chains[i]] = 1;
+            int kept = 0;
+            for (int i=0; i<n; i++) {
+                if (!onHull[i]) continue;
+                point swap = Points[kept];
+                Points[kept++] = Points[i];
+                Points[i] = swap;
+            }
+            n = kept;
+        }
+        free(G.chains);
+        free(G.starts);
+        free(hull);
+    }
+    free(tmp);
+    free(onHull);
+    if (k < 0)
+        return convexHullIndices(Points, all, out);
+    return k;
+}
+
+/*
+ * Batches:
+ * Many small point sets stored one after the other, like the rows of a CSR
+ * matrix, are hulled into a single output buffer. Threads claim blocks of
+ * sets from a shared counter, so sets of uneven size still balance, and
+ * tiny sets are sorted by insertion sort instead of qsort.
+ */
+#define BATCH_BLOCK 256         // sets claimed at a time by a thread
+#define BATCH_INSERTION_SORT 24 // largest set sorted by insertion sort
+
+struct batchShared {
+    int sets;
+    void (*run)(void *context, int first, int end);
+    void *context;
+    int next; // first set not claimed yet
+    pthread_mutex_t lock;
+};
+struct batchJob {
+    struct batchShared *S;
+};
+struct batchHulls {
+    point *Points;
+    const int *starts;
+    int *out;
+    int *hullStarts;
+};
+
+static void insertionSort(point *Points, int n) {
+    for (int i=1; i<n; i++) {
+        point p = Points[i];
+        int j = i;
+        for (; j>0 && cmp(&Points[j-1], &p) > 0; j--)
+            Points[j] = Points[j-1];
+        Points[j] = p;
+    }
+}
+
+static void *batchWorker(void *arg) {
+    struct batchShared *S = ((struct batchJob *)arg)->S;
+    for (;;) {
+        pthread_mutex_lock(&S->lock);
+        int first = S->next;
+        S->next = (S->sets - first > BATCH_BLOCK ? first + BATCH_BLOCK : S->sets);
+        int end = S->next;
+        pthread_mutex_unlock(&S->lock);
+        if (first == end) return NULL;
+        S->run(S->context, first, end);
+    }
+}
+
+/**
+ * Runs work on blocks of sets with a few threads, which claim the blocks
+ * from a shared counter (as convexHullBatch() does).
+ * @param  sets    Number of sets
+ * @param  threads Number of threads to use
+ * @param  run     Works on sets first..end-1, with context
+ * @param  context Passed to run
+ */
+void convexHullBatchRun(int sets, int threads, void (*run)(void *context, int first, int end),
+                        void *context) {
+    threads = min(threads, min((sets + BATCH_BLOCK-1) / BATCH_BLOCK, PARALLEL_MAX_THREADS));
+    threads = max(threads, 1);
+    struct batchShared S = { sets, run, context, 0, PTHREAD_MUTEX_INITIALIZER };
+    struct batchJob jobs[PARALLEL_MAX_THREADS];
+    for (int t=0; t<threads; t++)
+        jobs[t].S = &S;
+    runWorkers(batchWorker, jobs, sizeof(struct batchJob), threads);
+    pthread_mutex_destroy(&S.lock);
+}
+
+static void hullSets(void *context, int first, int end) {
+    struct batchHulls *B = context;
+    for (int s=first; s<end; s++) {
+        point *P = &B->Points[B->starts[s]];
+        int n = B->starts[s+1] - B->starts[s];
+        if (n <= BATCH_INSERTION_SORT)
+            insertionSort(P, n);
+        else
+            qsort(P, n, sizeof(point), cmp);
+        // Until compacted, the hull of set s is at out[starts[s]+s..]
+        // and its size in hullStarts[s+1]
+        B->hullStarts[s+1] = convexHullSorted(P, n, &B->out[B->starts[s] + s]);
+    }
+}
+
+/**
+ * Computes the convex hulls [CH()] of many point sets with a few threads.
+ * Each set is sorted lexicographically in place, and its hull is given by
+ * indices into the sorted set, like convexHullIndices() does.
+ * @param  Points     All point sets, one after the other
+ * @param  starts     Set s is Points[starts[s]..starts[s+1]-1]; sets+1 offsets
+ * @param  sets       Number of sets
+ * @param  out        Receives the hulls one after the other, the hull of set s
+ *                    in out[hullStarts[s]..hullStarts[s+1]-1];
+ *                    room for starts[sets]+sets indices
+ * @param  hullStarts Receives sets+1 offsets into out
+ * @param  threads    Number of threads to use
+ * @return            Total number of vertices written to out
+ */
+int convexHullBatch(point *Points, const int *starts, int sets, int *out,
+                    int *hullStarts, int threads) {
+    struct batchHulls B = { Points, starts, out, hullStarts };
+    convexHullBatchRun(sets, threads, hullSets, &B);
+
+    // Move the hulls together (never onto a hull that is still to be moved)
+    hullStarts[0] = 0;
+    for (int s=0; s<sets; s++) {
+        int h = hullStarts[s+1];
+        memmove(&out[hullStarts[s]], &out[starts[s] + s], h*sizeof(int));
+        hullStarts[s+1] = hullStarts[s] + h;
+    }
+    return hullStarts[sets];
+}
+
+/*
+ * External memory:
+ * Points too many for memory are read in chunks into a single buffer whose
+ * size is fixed by a memory budget. The buffer always starts with the
+ * vertices of the hull of everything read so far, the next chunk is read
+ * behind them, and the hull of both (Akl-Toussaint filtered, then by the
+ * monotone chain) is moved to the front again. Thus the hulls of the chunks
+ * are merged as they are read, and the buffer never grows; only the hull
+ * itself has to fit. Chunks are sorted in place by introsort, since qsort
+ * may allocate a copy of them outside the budget.
+ */
+
+static void siftDown(point *Points, int i, int n) {
+    point p = Points[i];
+    for (;;) {
+        int c = 2*i + 1;
+        if (c >= n) break;
+        if (c+1 < n && cmp(&Points[c], &Points[c+1]) < 0) c++;
+        if (cmp(&p, &Points[c]) >= 0) break;
+        Points[i] = Points[c];
+        i = c;
+    }
+    Points[i] = p;
+}
+
+static void heapSort(point *Points, int n) {
+    for (int i=n/2-1; i>=0; i--)
+        siftDown(Points, i, n);
+    for (int i=n-1; i>0; i--) {
+        point p = Points[0];
+        Points[0] = Points[i];
+        Points[i] = p;
+        siftDown(Points, 0, i);
+    }
+}
+
+// Quicksort on the median of three, recursing into the smaller part only;
+// heapsort after depth partitions and insertion sort for small ranges
+static void introSort(point *Points, int n, int depth) {
+    while (n > BATCH_INSERTION_SORT) {
+        if (depth-- == 0) {
+            heapSort(Points, n);
+            return;
+        }
+        const point *a = &Points[0], *b = &Points[n/2], *c = &Points[n-1];
+        point pivot = (cmp(a, b) < 0
+                       ? (cmp(b, c) < 0 ? *b : cmp(a, c) < 0 ? *c : *a)
+                       : (cmp(a, c) < 0 ? *a : cmp(b, c) < 0 ? *c : *b));
+        int i = -1, j = n;
+        for (;;) {
+            do i++; while (cmp(&Points[i], &pivot) < 0);
+            do j--; while (cmp(&Points[j], &pivot) > 0);
+            if (i >= j) break;
+            point p = Points[i];
+            Points[i] = Points[j];
+            Points[j] = p;
+        }
+        int left = j + 1;
+        if (left < n - left) {
+            introSort(Points, left, depth);
+            Points += left;
+            n -= left;
+        } else {
+            introSort(Points + left, n - left, depth);
+            n = left;
+        }
+    }
+    insertionSort(Points, n);
+}
+
+/*
+ * Moves the hull vertices out[0..h-1] of the sorted Points[0..n-1] to the
+ * front of Points, keeping them sorted. The upper part of out ascends to
+ * n-1, the lower part descends, so this is a merge of the two.
+ * Afterwards out[i] is the new position of the i-th vertex.
+ */
+static void compactHull(point *Points, int n, int *out, int h) {
+    int upper = 0;
+    while (out[upper] != n-1)
+        upper++;
+    int a = 0, b = h-1;
+    for (int j=0; j<h; j++) {
+        int *next = (b <= upper || (a <= upper && out[a] < out[b]) ? &out[a++] : &out[b--]);
+        Points[j] = Points[*next];
+        *next = j;
+    }
+}
+
+// Reorders Points[0..h-1] to Points[order[0]], Points[order[1]], ...
+static void permutePoints(point *Points, int *order, int h) {
+    for (int i=0; i<h; i++) {
+        if (order[i] < 0) continue;
+        point first = Points[i];
+        int j = i;
+        while (order[j] != i) {
+            int k = order[j];
+            Points[j] = Points[k];
+            order[j] = -1;
+            j = k;
+        }
+        Points[j] = first;
+        order[j] = -1;
+    }
+}
+
+/**
+ * Reads points stored as pairs of 32 bit x and y (native byte order) from
+ * a file, e.g. the points of a point file behind its header (pointfile.hpp).
+ * @param  file   An open FILE
+ * @param  buffer Receives up to max points (only x and y are set)
+ * @return        Number of points read, 0 at the end, -1 on error
+ */
+int convexHullReadInt32(void *file, point *buffer, int max) {
+    // Read into the front of buffer and widen in place from the back
+    int32_t *raw = (int32_t *)buffer;
+    size_t k = fread(raw, 2*sizeof(int32_t), max, file);
+    if (k == 0 && ferror(file)) return -1;
+    for (int i=(int)k-1; i>=0; i--) {
+        int32_t xy[2];
+        memcpy(xy, &raw[2*i], sizeof(xy));
+        buffer[i].x = xy[0];
+        buffer[i].y = xy[1];
+    }
+    return (int)k;
+}
+
+/**
+ * Computes the convex hull [CH()] of points read chunk by chunk, using
+ * memory bounded by budget however many points are read.
+ * @param  read    Reads up to max points into buffer and returns their
+ *                 number, 0 at the end or -1 on error
+ *                 (see convexHullReadInt32())
+ * @param  context Passed to read
+ * @param  budget  Bytes of memory to use, sizeof(point)+sizeof(int) per
+ *                 point of the hull and of a chunk; nothing else is allocated
+ * @param  hull    Receives the vertices of CH(P) in clockwise order, to be
+ *                 released with free()
+ * @return         Number of vertices of CH(P), or -1 if reading failed, the
+ *                 hull does not fit into the budget or memory is exhausted
+ */
+int convexHullExternal(int (*read)(void *context, point *buffer, int max),
+                       void *context, size_t budget, point **hull) {
+    // One slot more than the hull may use, so that a full buffer can still
+    // be told apart from the end of the input
+    size_t fit = budget / (sizeof(point) + sizeof(int));
+    int capacity = (int)min(fit, (size_t)INT_MAX) - 1;
+    *hull = NULL;
+    if (capacity < 1) return -1;
+    point *buffer = malloc((capacity+1)*sizeof(point));
+    int *out = malloc((capacity+1)*sizeof(int));
+    if (buffer == NULL || out == NULL) {
+        free(buffer);
+        free(out);
+        return -1;
+    }
+
+    int h = 0, m;
+    while ((m = read(context, &buffer[h], max(capacity - h, 1))) > 0
+           && h < capacity) {
+        // The old hull usually spans most of the new points, which are
+        // then discarded before sorting
+        int n = convexHullPrefilter(buffer, h + min(m, capacity - h));
+        int depth = 0;
+        for (int k=n; k>1; k/=2)
+            depth += 2;
+        introSort(buffer, n, depth);
+        h = convexHullSorted(buffer, n, out);
+        compactHull(buffer, n, out, h);
+    }
+    if (m != 0) { // a read error, or more points and the hull fills the buffer
+        free(buffer);
+        free(out);
+        return -1;
+    }
+
+    // out maps the clockwise order to the sorted vertices in front
+    permutePoints(buffer, out, h);
+    free(out);
+    point *shrunk = realloc(buffer, max(h, 1)*sizeof(point));
+    *hull = (shrunk != NULL ? shrunk : buffer);
+    return h;
+}
+
 /**
+ * [Chan96]
+ *     Timothy M. Chan, "Optimal output-sensitive convex hull algorithms in two
+ *     and three dimensions", Discrete & Computational Geometry 16 (1996)
+ *
  * [CompGeo08]
  *     Computational Geometry: Algorithms and Applications, Third edition,
  *     Mark de Berg, Otfried Cheong, Marc van Kreveld, Mark Overmars
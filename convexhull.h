@@ -2,13 +2,22 @@
 #define __convexhull_h
 
 #include <math.h>
+#include <float.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#ifndef CH_HEADLESS
 #include <SDL2/SDL.h>
+#endif
 // Using BSD queue.h for datastructures
 // http://stackoverflow.com/a/668567
 #include "lib/queue.h"
+#include "lib/predicates.h"
 
 #define true 1
 #define false 0
@@ -16,9 +25,81 @@
 // Extends CIRCLEQ
 #define CIRCLEQ_NEW(name, variable) struct name *variable = malloc(sizeof(struct name));
 
+#ifndef __cplusplus // would clash with std::min and std::max
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 #define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
 
-struct circleq *convexHull(SDL_Rect *Points, int n);
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Only x and y of a point are used by the convex hull computations. Compiled
+// with CH_HEADLESS the module does not need SDL and uses 8 byte points.
+#ifdef CH_HEADLESS
+typedef struct point {
+    int x, y;
+} point;
+#else
+typedef SDL_Rect point;
+#endif
+
+// The list of hull vertices returned by convexHull() and convexHullWith(),
+// walked with CIRCLEQ_FOREACH(e, chull, entries)
+CIRCLEQ_HEAD(circleq, entry);
+struct entry {
+    point *rect;
+    CIRCLEQ_ENTRY(entry) entries;
+};
+
+// Phase timings in seconds of the last call, recorded with CH_TIMING only
+struct hullTimings {
+    double sort, chain, merge;
+};
+extern struct hullTimings convexHullTimings;
+
+/**
+ * Caller-owned state of convexHullWith(): the allocator of the scratch space
+ * and of the returned lists, an optional logging hook, and the scratch space
+ * itself, kept between calls. One context per thread.
+ */
+struct hullContext {
+    void *(*alloc)(void *user, size_t size);
+    void (*release)(void *user, void *block);
+    void (*log)(void *user, const char *message); // NULL for no logging
+    void *user;                                   // passed to the hooks
+    int *hull;                                    // scratch space for
+    point *tmp;                                   // capacity points
+    size_t capacity;
+    struct hullTimings timings;                   // with CH_TIMING only
+};
+
+int crossSign(long long ux, long long uy, long long vx, long long vy);
+int ccw(const point *p1, const point *p2, const point *p3);
+int comparePoints(const point *p, const point *q);
+struct circleq *convexHull(point *Points, int n);
+void convexHullFree(struct circleq *chull);
+void convexHullContextInit(struct hullContext *ctx);
+void convexHullContextFree(struct hullContext *ctx);
+struct circleq *convexHullWith(struct hullContext *ctx, point *Points, int n);
+void convexHullFreeWith(struct hullContext *ctx, struct circleq *chull);
+int convexHullIndices(point *Points, int n, int *out);
+int convexHullSorted(const point *Points, int n, int *out);
+void sortPoints(point *Points, int n, point *tmp);
+int convexHullPrefilter(point *Points, int n);
+int convexHullParallel(point *Points, int n, int *out, int threads);
+int convexHullChan(point *Points, int n, int *out);
+int convexHullBatch(point *Points, const int *starts, int sets, int *out,
+                    int *hullStarts, int threads);
+void convexHullBatchRun(int sets, int threads, void (*run)(void *context, int first, int end),
+                        void *context);
+int convexHullReadInt32(void *file, point *buffer, int max);
+int convexHullExternal(int (*read)(void *context, point *buffer, int max),
+                       void *context, size_t budget, point **hull);
+void randomDiskPoints(point *Points, int n, int cx, int cy, int radius);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* __convexhull_h */
\ No newline at end of file
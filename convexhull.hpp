@@ -0,0 +1,309 @@
+#ifndef __convexhull_hpp
+#define __convexhull_hpp
+
+/**
+ * Header-only convex hull [CH()] for any point type with public members x
+ * and y. The coordinate type is taken from the point type and selects the
+ * orientation predicate at compile time, so e.g. an 8 byte int32 point or a
+ * double point can be used directly, without SDL or conversions.
+ * Same algorithm and vertex order as convexhull.c.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "lib/predicates.h"
+
+namespace compgeo {
+
+template <class T>
+struct Point2 {
+    T x, y;
+};
+
+template <class P>
+using coordOf = typename std::remove_cv<
+    typename std::remove_reference<decltype(std::declval<P>().x)>::type>::type;
+
+/**
+ * Orientation predicates, specialized per coordinate type.
+ * sign() is positive if p1, p2, p3 is a counter-clockwise turn, negative if
+ * clockwise, and zero if collinear (as ccw() in convexhull.c).
+ */
+template <class T, class Enable = void>
+struct Orientation;
+
+// Integers up to 32 bit: exact in 128 bit arithmetic (differences of full
+// range int32 coordinates already overflow 64 bit products)
+template <class T>
+struct Orientation<T, typename std::enable_if<std::is_integral<T>::value
+                                              && sizeof(T) <= 4>::type> {
+    template <class P>
+    static int sign(const P &p1, const P &p2, const P &p3) {
+        __int128 det = (__int128(p2.x) - p1.x) * (__int128(p3.y) - p1.y)
+                     - (__int128(p2.y) - p1.y) * (__int128(p3.x) - p1.x);
+        return (det > 0) - (det < 0);
+    }
+};
+
+// 64 bit integers: differences take 65 bits, so their products may overflow
+// 128 bit ints. Both products are compared exactly by sign and magnitude
+// instead (a magnitude is below 2^64, its product below 2^128 unsigned).
+template <class T>
+struct Orientation<T, typename std::enable_if<std::is_integral<T>::value
+                                              && sizeof(T) == 8>::type> {
+    // Sign of a*b - c*d
+    static int compareProducts(__int128 a, __int128 b, __int128 c, __int128 d) {
+        const __int128 M = __int128(1) << 62;
+        if (a > -M && a < M && b > -M && b < M && c > -M && c < M && d > -M && d < M) {
+            __int128 det = a*b - c*d;
+            return (det > 0) - (det < 0);
+        }
+        int s = ((a > 0) - (a < 0)) * ((b > 0) - (b < 0)),
+            t = ((c > 0) - (c < 0)) * ((d > 0) - (d < 0));
+        if (s != t || s == 0)
+            return (s > t) - (s < t);
+        typedef unsigned __int128 uint128;
+        uint128 m1 = uint128(std::uint64_t(a < 0 ? -a : a)) * std::uint64_t(b < 0 ? -b : b),
+                m2 = uint128(std::uint64_t(c < 0 ? -c : c)) * std::uint64_t(d < 0 ? -d : d);
+        return s * ((m1 > m2) - (m1 < m2));
+    }
+    template <class P>
+    static int sign(const P &p1, const P &p2, const P &p3) {
+        return compareProducts(__int128(p2.x) - p1.x, __int128(p3.y) - p1.y,
+                               __int128(p2.y) - p1.y, __int128(p3.x) - p1.x);
+    }
+};
+
+// Floating point: filtered, with an exact fallback for near-degenerate
+// triples (see lib/predicates.h); float is widened to double exactly
+template <class T>
+struct Orientation<T, typename std::enable_if<std::is_floating_point<T>::value
+                                              && sizeof(T) <= sizeof(double)>::type> {
+    template <class P>
+    static int sign(const P &p1, const P &p2, const P &p3) {
+        const double a[2] = {double(p1.x), double(p1.y)},
+                     b[2] = {double(p2.x), double(p2.y)},
+                     c[2] = {double(p3.x), double(p3.y)};
+        double det = orient2d(a, b, c);
+        return (det > 0) - (det < 0);
+    }
+};
+
+template <class P>
+inline int orientation(const P &p1, const P &p2, const P &p3) {
+    return Orientation<coordOf<P>>::sign(p1, p2, p3);
+}
+
+template <class P>
+inline bool makeRightTurn(const P &p1, const P &p2, const P &p3) {
+    return orientation(p1, p2, p3) > 0;
+}
+
+// Lexicographic order on (x,y)
+template <class P>
+inline bool lessXY(const P &p, const P &q) {
+    return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+/**
+ * Computes the convex hull [CH()] of lexicographically sorted points.
+ * @param  pts A set of points (in the plane), sorted lexicographically;
+ *             anything indexable by pts[i], e.g. an array
+ * @param  n   Number of points in pts
+ * @param  out Receives the indices of the vertices of CH(P) in clockwise
+ *             order; room for n+1 indices
+ * @return     Number of vertices of CH(P) written to out
+ */
+template <class Points, class Index>
+std::size_t convexHullSorted(const Points &pts, std::size_t n, Index *out) {
+    std::size_t k = 0;
+    if (n == 0) return 0;
+    auto push = [&](std::size_t base, std::size_t i) {
+        while (k > base+1 && !makeRightTurn(pts[out[k-2]], pts[out[k-1]], pts[i]))
+            k--;
+        out[k++] = Index(i);
+    };
+    // Upper part
+    for (std::size_t i=0; i<n; i++)
+        push(0, i);
+    // Lower part (continues from the last point of the upper part)
+    std::size_t upperSize = k;
+    for (std::size_t i=n-1; i-- > 0; )
+        push(upperSize-1, i);
+    // pts[0] is pushed again as the last point, but already starts the hull
+    return (n > 1 ? k-1 : k);
+}
+
+/**
+ * Computes the convex hull [CH()], sorting pts lexicographically in place.
+ * @return Number of vertices of CH(P) written to out (indices into sorted pts)
+ */
+template <class P, class Index>
+std::size_t convexHull(P *pts, std::size_t n, Index *out) {
+    std::sort(pts, pts+n, lessXY<P>);
+    return convexHullSorted(pts, n, out);
+}
+
+/**
+ * Computes the convex hull [CH()] of points that must not be reordered, e.g.
+ * read-only or memory mapped data. An index permutation is sorted instead.
+ * @return Indices into pts of the vertices of CH(P) in clockwise order
+ */
+template <class P, class Index = std::size_t>
+std::vector<Index> convexHullIndexed(const P *pts, std::size_t n) {
+    std::vector<Index> order(n), out(n+1);
+    for (std::size_t i=0; i<n; i++)
+        order[i] = Index(i);
+    std::sort(order.begin(), order.end(), [pts](Index a, Index b) {
+        return lessXY(pts[a], pts[b]);
+    });
+    // Run the chain over the permuted points
+    struct view {
+        const P *pts;
+        const Index *order;
+        const P &operator[](std::size_t i) const { return pts[order[i]]; }
+    };
+    out.resize(convexHullSorted(view { pts, order.data() }, n, out.data()));
+    for (auto &i : out)
+        i = order[i];
+    return out;
+}
+
+/**
+ * Computes the convex hull [CH()] of points that must not be reordered,
+ * reading them in two sequential passes, as suits memory mapped files:
+ * the first finds the extreme points in 16 directions, the second keeps the
+ * points that are not strictly inside the polygon of those (Akl-Toussaint),
+ * and only those are sorted, by index. For uniform points in a disk about
+ * 2.5% are kept. The keys of the directions are rounded, which is safe: a
+ * point left of every edge of the polygon is inside the hull of its
+ * vertices, whether the polygon turned out convex or not.
+ * @return Indices into pts of the vertices of CH(P) in clockwise order
+ */
+template <class P, class Index = std::size_t>
+std::vector<Index> convexHullFiltered(const P *pts, std::size_t n) {
+    const int K = 16;
+    if (n == 0) return std::vector<Index>();
+    // Directions by increasing angle, so the polygon is counter-clockwise
+    double dx[K], dy[K], best[K];
+    std::size_t extreme[K];
+    for (int k=0; k<K; k++) {
+        dx[k] = std::cos(2 * M_PI * k / K);
+        dy[k] = std::sin(2 * M_PI * k / K);
+        best[k] = -HUGE_VAL;
+        extreme[k] = 0;
+    }
+    double maxAbs = 0;
+    for (std::size_t i=0; i<n; i++) {
+        double x = double(pts[i].x), y = double(pts[i].y);
+        maxAbs = std::max(maxAbs, std::max(std::fabs(x), std::fabs(y)));
+        for (int k=0; k<K; k++) {
+            double key = dx[k]*x + dy[k]*y;
+            if (key > best[k]) {
+                best[k] = key;
+                extreme[k] = i;
+            }
+        }
+    }
+    std::vector<std::size_t> polygon;
+    for (int k=0; k<K; k++) {
+        const P &p = pts[extreme[k]];
+        if (polygon.empty() || pts[polygon.back()].x != p.x || pts[polygon.back()].y != p.y)
+            polygon.push_back(extreme[k]);
+    }
+    while (polygon.size() > 1 && pts[polygon.back()].x == pts[polygon[0]].x
+                              && pts[polygon.back()].y == pts[polygon[0]].y)
+        polygon.pop_back();
+    // The side of an edge is decided in doubles where that is safe: the
+    // orientation is off by a few roundings of products of (differences of)
+    // coordinates up to maxAbs, and else decided by orientation()
+    struct edge {
+        double x0, y0, ex, ey;
+    };
+    std::vector<P> ring; // the polygon, closed
+    std::vector<edge> edges;
+    for (std::size_t k=0; k<=polygon.size(); k++)
+        ring.push_back(pts[polygon[k % polygon.size()]]);
+    for (std::size_t k=0; k<polygon.size(); k++) {
+        double x0 = double(ring[k].x), y0 = double(ring[k].y);
+        edges.push_back(edge { x0, y0, double(ring[k+1].x) - x0, double(ring[k+1].y) - y0 });
+    }
+    const double bound = 64 * DBL_EPSILON * maxAbs * maxAbs;
+    auto inside = [&](const P &p) {
+        if (polygon.size() < 3) return false;
+        double x = double(p.x), y = double(p.y);
+        for (std::size_t k=0; k<edges.size(); k++) {
+            const edge &e = edges[k];
+            double o = e.ex * (y - e.y0) - e.ey * (x - e.x0);
+            if (o > bound) continue;
+            if (o < -bound || orientation(ring[k], ring[k+1], p) <= 0)
+                return false;
+        }
+        return true;
+    };
+
+    // Most points are inside a box between the sides of the polygon, which
+    // is cheaper to test. The box is shrunk until its corners are inside,
+    // then so is all of it (left of every edge is a convex region).
+    using T = coordOf<P>;
+    auto sideOf = [&](int from, int to, bool useX, bool largest) {
+        double v = largest ? -HUGE_VAL : HUGE_VAL;
+        for (int k=from; k<=to; k++) {
+            const P &p = pts[extreme[(k+K) % K]];
+            double c = double(useX ? p.x : p.y);
+            v = (largest ? std::max(v, c) : std::min(v, c));
+        }
+        return v;
+    };
+    double right = sideOf(-K/8, K/8, true, false), top = sideOf(K/8, 3*K/8, false, false),
+           left = sideOf(3*K/8, 5*K/8, true, true), bottom = sideOf(5*K/8, 7*K/8, false, true);
+    T boxLeft = T(), boxRight = T(), boxBottom = T(), boxTop = T();
+    bool box = false;
+    for (double shrink = 1.0/64; !box && shrink < 0.5 && left < right && bottom < top; shrink *= 4) {
+        double w = (right - left) * shrink, h = (top - bottom) * shrink;
+        boxLeft = T(left + w);
+        boxRight = T(right - w);
+        boxBottom = T(bottom + h);
+        boxTop = T(top - h);
+        box = true;
+        for (int c=0; box && c<4; c++) {
+            P corner = pts[0];
+            corner.x = (c & 1 ? boxRight : boxLeft);
+            corner.y = (c & 2 ? boxTop : boxBottom);
+            box = inside(corner);
+        }
+    }
+
+    std::vector<Index> candidates;
+    for (std::size_t i=0; i<n; i++) {
+        const P &p = pts[i];
+        if (box && p.x > boxLeft && p.x < boxRight && p.y > boxBottom && p.y < boxTop)
+            continue;
+        if (!inside(p))
+            candidates.push_back(Index(i));
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [pts](Index a, Index b) {
+        return lessXY(pts[a], pts[b]);
+    });
+    struct view {
+        const P *pts;
+        const Index *order;
+        const P &operator[](std::size_t i) const { return pts[order[i]]; }
+    };
+    std::vector<Index> out(candidates.size()+1);
+    out.resize(convexHullSorted(view { pts, candidates.data() }, candidates.size(), out.data()));
+    for (auto &i : out)
+        i = candidates[i];
+    return out;
+}
+
+} // namespace compgeo
+
+#endif /* __convexhull_hpp */
@@ -0,0 +1,679 @@
+#include "convexhull3d.h"
+
+/**
+ * Convex hull in space by Quickhull [BDH96]: starting from a tetrahedron,
+ * every face keeps the set of points above it (its outside set), and the
+ * furthest point of an outside set is added by replacing the faces it sees
+ * with a cone of new faces to their horizon. The points of the removed faces
+ * are partitioned among the new faces, and a point above none of them is
+ * inside the hull for good. This takes O(n log n) expected time for points
+ * in general position.
+ *
+ * Coordinates are integers and above/below is decided exactly, so faces may
+ * be coplanar with their neighbours but the hull is never self-intersecting.
+ * Points are never moved: the hull refers to them by index.
+ */
+
+__extension__ typedef __int128 int128;
+
+// The determinant [b-a, c-a, d-a] in floating point
+static double volume(const point3 *a, const point3 *b, const point3 *c, const point3 *d) {
+    double bx = (double)b->x - a->x, by = (double)b->y - a->y, bz = (double)b->z - a->z,
+           cx = (double)c->x - a->x, cy = (double)c->y - a->y, cz = (double)c->z - a->z,
+           dx = (double)d->x - a->x, dy = (double)d->y - a->y, dz = (double)d->z - a->z;
+    return bx*(cy*dz - cz*dy) - by*(cx*dz - cz*dx) + bz*(cx*dy - cy*dx);
+}
+
+/**
+ * Three points a, b and c seen counter-clockwise from point d have
+ * orient3d > 0, seen clockwise from d orient3d < 0, and orient3d = 0 if
+ * the four points are coplanar. It is the sign of the determinant
+ * [b-a, c-a, d-a], exact in 128 bit integers.
+ */
+static int orient3d(const point3 *a, const point3 *b, const point3 *c, const point3 *d) {
+    long long bx = (long long)b->x - a->x, by = (long long)b->y - a->y, bz = (long long)b->z - a->z,
+              cx = (long long)c->x - a->x, cy = (long long)c->y - a->y, cz = (long long)c->z - a->z,
+              dx = (long long)d->x - a->x, dy = (long long)d->y - a->y, dz = (long long)d->z - a->z;
+    int128 det = bx * ((int128)cy*dz - (int128)cz*dy)
+               - by * ((int128)cx*dz - (int128)cz*dx)
+               + bz * ((int128)cx*dy - (int128)cy*dx);
+    return (det > 0) - (det < 0);
+}
+
+// Normal (b-a) x (c-a) of the plane through a, b and c, exact
+static void normal(const point3 *a, const point3 *b, const point3 *c, int128 N[3]) {
+    long long bx = (long long)b->x - a->x, by = (long long)b->y - a->y, bz = (long long)b->z - a->z,
+              cx = (long long)c->x - a->x, cy = (long long)c->y - a->y, cz = (long long)c->z - a->z;
+    N[0] = (int128)by*cz - (int128)bz*cy;
+    N[1] = (int128)bz*cx - (int128)bx*cz;
+    N[2] = (int128)bx*cy - (int128)by*cx;
+}
+
+static int isZero(const int128 N[3]) {
+    return N[0] == 0 && N[1] == 0 && N[2] == 0;
+}
+
+/*
+ * Faces
+ */
+
+// A point of an outside set, with a copy of its coordinates so that the
+// sets are scanned without jumping around in the points
+struct outsidePoint {
+    point3 p;
+    int k; // local index
+};
+
+struct face3 {
+    int v[3];              // local vertex indices, counter-clockwise seen from outside
+    point3 base;           // the point v[0]
+    double normal[3];      // rounded normal of the plane of the face
+    double bound;          // error bound of the distance to the plane (see isAbove())
+    struct face3 *adj[3];  // adj[i] is the face across the edge v[i] -> v[i+1]
+    struct outsidePoint *outside; // the points above the face
+    int outsideSize, outsideCapacity;
+    int visible;           // last round in which the face was seen
+    int alive;
+    int id;                // index in the output
+    struct face3 *next;    // in the free list of the pool
+};
+
+/**
+ * Faces come from a pool of fixed size chunks: a round of Quickhull frees
+ * about as many faces as it creates, so faces are recycled through a free
+ * list instead of going back and forth to malloc. A recycled face keeps the
+ * buffer of its outside set.
+ */
+#define POOL_CHUNK 1024
+
+struct faceChunk {
+    struct faceChunk *next;
+    struct face3 faces[POOL_CHUNK];
+};
+
+struct facePool {
+    struct faceChunk *chunks; // newest first
+    int used;                 // faces handed out from the newest chunk
+    struct face3 *free;
+};
+
+static struct face3 *newFace(struct facePool *pool, int a, int b, int c) {
+    struct face3 *f = pool->free;
+    if (f != NULL) {
+        pool->free = f->next;
+    } else {
+        if (pool->chunks == NULL || pool->used == POOL_CHUNK) {
+            struct faceChunk *chunk = malloc(sizeof(struct faceChunk));
+            if (chunk == NULL) return NULL;
+            chunk->next = pool->chunks;
+            pool->chunks = chunk;
+            pool->used = 0;
+        }
+        f = &pool->chunks->faces[pool->used++];
+        f->outside = NULL;
+        f->outsideCapacity = 0;
+    }
+    f->v[0] = a;
+    f->v[1] = b;
+    f->v[2] = c;
+    f->adj[0] = f->adj[1] = f->adj[2] = NULL;
+    f->outsideSize = 0;
+    f->visible = 0;
+    f->alive = true;
+    return f;
+}
+
+// Calls visit on every face ever handed out by the pool, dead or alive
+#define POOL_FOREACH(pool, f, visit) \
+    for (struct faceChunk *chunk_ = (pool)->chunks; chunk_ != NULL; chunk_ = chunk_->next) \
+        for (int i_ = 0; i_ < (chunk_ == (pool)->chunks ? (pool)->used : POOL_CHUNK); i_++) { \
+            struct face3 *f = &chunk_->faces[i_]; \
+            visit; \
+        }
+
+static void freeFace(struct facePool *pool, struct face3 *f) {
+    f->alive = false;
+    f->next = pool->free;
+    pool->free = f;
+}
+
+static void freePool(struct facePool *pool) {
+    POOL_FOREACH(pool, f, free(f->outside));
+    while (pool->chunks != NULL) {
+        struct faceChunk *chunk = pool->chunks;
+        pool->chunks = chunk->next;
+        free(chunk);
+    }
+}
+
+struct faceStack {
+    struct face3 **items;
+    int size, capacity;
+};
+
+static int pushFace(struct faceStack *S, struct face3 *f) {
+    if (S->size == S->capacity) {
+        int capacity = (S->capacity > 0 ? 2*S->capacity : 64);
+        struct face3 **items = realloc(S->items, capacity*sizeof(struct face3 *));
+        if (items == NULL) return false;
+        S->items = items;
+        S->capacity = capacity;
+    }
+    S->items[S->size++] = f;
+    return true;
+}
+
+// Index j of the edge v[j] -> v[j+1] of f that goes from a to b
+static int edgeIndex(const struct face3 *f, int a, int b) {
+    for (int j=0; j<3; j++)
+        if (f->v[j] == a && f->v[(j+1)%3] == b)
+            return j;
+    return -1;
+}
+
+/*
+ * Quickhull
+ */
+
+struct hull3Build {
+    const point3 *P;  // the points
+    const int *ids;   // local index -> index into P
+    int m;            // number of local points
+    struct face3 **horizonFrom; // new face by the start of its horizon edge
+    double range[3];  // extent of the points in each coordinate
+    struct facePool pool;
+    struct faceStack pending, visible, cone;
+};
+
+#define PT(B, k) (&(B)->P[(B)->ids[k]])
+
+/**
+ * Creates the face a, b, c with its plane. The normal is computed from exact
+ * coordinate differences with a few roundings, so the distance of any point
+ * to the plane is off by at most a few roundings of the sum of
+ * |products| times the extent of the points.
+ */
+static struct face3 *makeFace(struct hull3Build *B, int a, int b, int c) {
+    struct face3 *f = newFace(&B->pool, a, b, c);
+    if (f == NULL) return NULL;
+    const point3 *p = PT(B, a), *q = PT(B, b), *r = PT(B, c);
+    double ux = (double)q->x - p->x, uy = (double)q->y - p->y, uz = (double)q->z - p->z,
+           vx = (double)r->x - p->x, vy = (double)r->y - p->y, vz = (double)r->z - p->z;
+    f->base = *p;
+    f->normal[0] = uy*vz - uz*vy;
+    f->normal[1] = uz*vx - ux*vz;
+    f->normal[2] = ux*vy - uy*vx;
+    f->bound = 8*DBL_EPSILON * ((fabs(uy*vz) + fabs(uz*vy)) * B->range[0]
+                              + (fabs(uz*vx) + fabs(ux*vz)) * B->range[1]
+                              + (fabs(ux*vy) + fabs(uy*vx)) * B->range[2]);
+    return f;
+}
+
+// Is q strictly above the face f? Exact, but only a few flops unless q is
+// (almost) in the plane of f
+static int isAbove(const struct hull3Build *B, const struct face3 *f, const point3 *q) {
+    double d = f->normal[0] * ((double)q->x - f->base.x)
+             + f->normal[1] * ((double)q->y - f->base.y)
+             + f->normal[2] * ((double)q->z - f->base.z);
+    if (d > f->bound) return true;
+    if (d < -f->bound) return false;
+    return orient3d(&f->base, PT(B, f->v[1]), PT(B, f->v[2]), q) > 0;
+}
+
+/**
+ * Adds a point to the outside set of the first face of F that it is above.
+ * @return false if out of memory
+ */
+static int assignOutside(struct hull3Build *B, struct face3 **F, int faces,
+                         const struct outsidePoint *q) {
+    for (int i=0; i<faces; i++) {
+        struct face3 *f = F[i];
+        if (!isAbove(B, f, &q->p)) continue;
+        if (f->outsideSize == f->outsideCapacity) {
+            int capacity = (f->outsideCapacity > 0 ? 2*f->outsideCapacity : 16);
+            struct outsidePoint *outside = realloc(f->outside, capacity*sizeof(struct outsidePoint));
+            if (outside == NULL) return false;
+            f->outside = outside;
+            f->outsideCapacity = capacity;
+        }
+        f->outside[f->outsideSize++] = *q;
+        return true;
+    }
+    return true;
+}
+
+static int furthestOutside(const struct hull3Build *B, const struct face3 *f) {
+    int best = 0;
+    double bestVolume = -1;
+    for (int i=0; i<f->outsideSize; i++) {
+        const point3 *q = &f->outside[i].p;
+        double v = f->normal[0] * ((double)q->x - f->base.x)
+                 + f->normal[1] * ((double)q->y - f->base.y)
+                 + f->normal[2] * ((double)q->z - f->base.z);
+        if (v > bestVolume) {
+            best = i;
+            bestVolume = v;
+        }
+    }
+    return f->outside[best].k;
+}
+
+/**
+ * Adds the point p, which is above the face f, to the hull.
+ * @return false if out of memory
+ */
+static int addPoint(struct hull3Build *B, struct face3 *f, int p, int round) {
+    B->visible.size = 0;
+    B->cone.size = 0;
+
+    // The faces that p is above are connected: search them from f, and
+    // create a new face on every edge to a face below p
+    f->visible = round;
+    if (!pushFace(&B->visible, f)) return false;
+    for (int s=0; s<B->visible.size; s++) {
+        struct face3 *g = B->visible.items[s];
+        for (int i=0; i<3; i++) {
+            struct face3 *h = g->adj[i];
+            if (h->visible == round) continue;
+            if (isAbove(B, h, PT(B, p))) {
+                h->visible = round;
+                if (!pushFace(&B->visible, h)) return false;
+                continue;
+            }
+            int a = g->v[i], b = g->v[(i+1)%3];
+            struct face3 *c = makeFace(B, a, b, p);
+            if (c == NULL || !pushFace(&B->cone, c)) return false;
+            c->adj[0] = h;
+            h->adj[edgeIndex(h, b, a)] = c;
+            B->horizonFrom[a] = c;
+        }
+    }
+    // Consecutive faces of the cone share an edge to p
+    for (int i=0; i<B->cone.size; i++) {
+        struct face3 *c = B->cone.items[i], *d = B->horizonFrom[c->v[1]];
+        c->adj[1] = d;
+        d->adj[2] = c;
+    }
+
+    // Partition the outside sets of the removed faces among the cone
+    for (int s=0; s<B->visible.size; s++) {
+        struct face3 *g = B->visible.items[s];
+        for (int i=0; i<g->outsideSize; i++)
+            if (g->outside[i].k != p && !assignOutside(B, B->cone.items, B->cone.size, &g->outside[i]))
+                return false;
+        freeFace(&B->pool, g);
+    }
+    for (int i=0; i<B->cone.size; i++)
+        if (B->cone.items[i]->outsideSize > 0 && !pushFace(&B->pending, B->cone.items[i]))
+            return false;
+    return true;
+}
+
+// Local index of the point furthest from a line or plane, by a score to maximize
+static int furthest(const struct hull3Build *B, double (*score)(const point3 *q, const point3 *const *S),
+                    const point3 *const *S) {
+    int best = 0;
+    double bestScore = -1;
+    for (int k=0; k<B->m; k++) {
+        double s = score(PT(B, k), S);
+        if (s > bestScore) {
+            best = k;
+            bestScore = s;
+        }
+    }
+    return best;
+}
+
+static double lineScore(const point3 *q, const point3 *const *S) {
+    double ux = (double)S[1]->x - S[0]->x, uy = (double)S[1]->y - S[0]->y, uz = (double)S[1]->z - S[0]->z,
+           vx = (double)q->x - S[0]->x, vy = (double)q->y - S[0]->y, vz = (double)q->z - S[0]->z,
+           nx = uy*vz - uz*vy, ny = uz*vx - ux*vz, nz = ux*vy - uy*vx;
+    return nx*nx + ny*ny + nz*nz;
+}
+
+static double planeScore(const point3 *q, const point3 *const *S) {
+    return fabs(volume(S[0], S[1], S[2], q));
+}
+
+static int hull3Output(struct hull3Build *B, hull3 *H);
+static int planarHull(struct hull3Build *B, int a, int b, int c, hull3 *H);
+
+/**
+ * Computes the hull of the points P[ids[0..m-1]].
+ * @return Number of faces, or -1 if out of memory
+ */
+static int hull3Build(const point3 *P, const int *ids, int m, hull3 *H) {
+    struct hull3Build B = { P, ids, m, NULL, { 0, 0, 0 }, { NULL, 0, NULL },
+                            { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+    int faces = -1;
+    H->faces = 0;
+    H->vertex = H->twin = NULL;
+    if (m < 3) return 0;
+
+    // Initial tetrahedron: two extreme points in x, the point furthest from
+    // their line and the point furthest from the plane of the three
+    int s[4] = { 0, 0, -1, -1 };
+    point3 lo = *PT(&B, 0), hi = lo;
+    for (int k=1; k<m; k++) {
+        const point3 *q = PT(&B, k);
+        if (q->x < PT(&B, s[0])->x) s[0] = k;
+        if (q->x > PT(&B, s[1])->x) s[1] = k;
+        lo.y = min(lo.y, q->y);
+        hi.y = max(hi.y, q->y);
+        lo.z = min(lo.z, q->z);
+        hi.z = max(hi.z, q->z);
+    }
+    B.range[0] = (double)PT(&B, s[1])->x - PT(&B, s[0])->x;
+    B.range[1] = (double)hi.y - lo.y;
+    B.range[2] = (double)hi.z - lo.z;
+    if (s[0] == s[1]) { // all points have the same x: any other point will do
+        for (int k=1; k<m && s[1] == s[0]; k++)
+            if (memcmp(PT(&B, k), PT(&B, 0), sizeof(point3)) != 0)
+                s[1] = k;
+        if (s[0] == s[1]) return 0; // a single point
+    }
+    const point3 *S[3] = { PT(&B, s[0]), PT(&B, s[1]), NULL };
+    int128 N[3];
+    s[2] = furthest(&B, lineScore, S);
+    normal(S[0], S[1], PT(&B, s[2]), N);
+    for (int k=0; k<m && isZero(N); k++) { // rounding fooled lineScore
+        s[2] = k;
+        normal(S[0], S[1], PT(&B, k), N);
+    }
+    if (isZero(N)) return 0; // collinear
+    S[2] = PT(&B, s[2]);
+    s[3] = furthest(&B, planeScore, S);
+    for (int k=0; k<m && orient3d(S[0], S[1], S[2], PT(&B, s[3])) == 0; k++)
+        s[3] = k;
+    if (orient3d(S[0], S[1], S[2], PT(&B, s[3])) == 0)
+        return planarHull(&B, s[0], s[1], s[2], H);
+
+    B.horizonFrom = malloc(m*sizeof(struct face3 *));
+    if (B.horizonFrom == NULL) goto cleanup;
+    // The fourth point must be below the base
+    if (orient3d(S[0], S[1], S[2], PT(&B, s[3])) > 0) {
+        int swap = s[1];
+        s[1] = s[2];
+        s[2] = swap;
+    }
+    struct face3 *T[4] = {
+        makeFace(&B, s[0], s[1], s[2]),
+        makeFace(&B, s[0], s[3], s[1]),
+        makeFace(&B, s[1], s[3], s[2]),
+        makeFace(&B, s[2], s[3], s[0]),
+    };
+    if (!T[0] || !T[1] || !T[2] || !T[3]) goto cleanup;
+    for (int i=0; i<4; i++)
+        for (int e=0; e<3; e++)
+            for (int j=0; j<4; j++) {
+                int back = edgeIndex(T[j], T[i]->v[(e+1)%3], T[i]->v[e]);
+                if (j != i && back != -1)
+                    T[i]->adj[e] = T[j];
+            }
+    for (int k=0; k<m; k++) {
+        struct outsidePoint q = { *PT(&B, k), k };
+        if (k != s[0] && k != s[1] && k != s[2] && k != s[3] && !assignOutside(&B, T, 4, &q))
+            goto cleanup;
+    }
+    for (int i=0; i<4; i++)
+        if (T[i]->outsideSize > 0 && !pushFace(&B.pending, T[i]))
+            goto cleanup;
+
+    for (int round = 1; B.pending.size > 0; ) {
+        struct face3 *f = B.pending.items[--B.pending.size];
+        if (!f->alive || f->outsideSize == 0) continue;
+        if (!addPoint(&B, f, furthestOutside(&B, f), round++))
+            goto cleanup;
+    }
+    faces = hull3Output(&B, H);
+
+cleanup:
+    freePool(&B.pool);
+    free(B.pending.items);
+    free(B.visible.items);
+    free(B.cone.items);
+    free(B.horizonFrom);
+    return faces;
+}
+
+static int hull3Alloc(hull3 *H, int faces) {
+    H->vertex = malloc(3*faces*sizeof(int));
+    H->twin = malloc(3*faces*sizeof(int));
+    if (H->vertex == NULL || H->twin == NULL) {
+        convexHull3dFree(H);
+        return -1;
+    }
+    H->faces = faces;
+    return faces;
+}
+
+static int hull3Output(struct hull3Build *B, hull3 *H) {
+    int faces = 0;
+    POOL_FOREACH(&B->pool, f, if (f->alive) f->id = faces++);
+    if (hull3Alloc(H, faces) < 0) return -1;
+    POOL_FOREACH(&B->pool, f, if (f->alive) {
+        for (int i=0; i<3; i++) {
+            const struct face3 *g = f->adj[i];
+            H->vertex[3*f->id + i] = B->ids[f->v[i]];
+            H->twin[3*f->id + i] = 3*g->id + edgeIndex(g, f->v[(i+1)%3], f->v[i]);
+        }
+    });
+    return faces;
+}
+
+/*
+ * Planar fast path
+ */
+
+struct planarVertex {
+    int x, y;
+    int slot; // position on the polygon
+};
+
+static int cmpPlanar(const void *a, const void *b) {
+    const struct planarVertex *p = a, *q = b;
+    if (p->x != q->x) return (p->x > q->x) - (p->x < q->x);
+    return (p->y > q->y) - (p->y < q->y);
+}
+
+static int128 abs128(int128 a) {
+    return (a < 0 ? -a : a);
+}
+
+/**
+ * All points are in the plane through the local points a, b and c: the hull
+ * is the 2D hull of their projection onto the coordinate plane most parallel
+ * to theirs, seen from both sides.
+ * @return Number of faces, or -1 if out of memory
+ */
+static int planarHull(struct hull3Build *B, int a, int b, int c, hull3 *H) {
+    int128 N[3];
+    normal(PT(B, a), PT(B, b), PT(B, c), N);
+    int drop = 0;
+    for (int i=1; i<3; i++)
+        if (abs128(N[i]) > abs128(N[drop])) drop = i;
+
+    int m = B->m, faces = -1, *out = malloc((m+1)*sizeof(int)), *polygon = NULL;
+    point *Q = calloc(m, sizeof(point));
+    struct planarVertex *V = NULL;
+    if (Q == NULL || out == NULL) goto cleanup;
+    for (int k=0; k<m; k++) {
+        const point3 *q = PT(B, k);
+        Q[k].x = (drop == 0 ? q->y : q->x);
+        Q[k].y = (drop == 2 ? q->y : q->z);
+    }
+    int h = convexHullIndices(Q, m, out);
+    if (h < 3) {
+        faces = 0;
+        goto cleanup;
+    }
+
+    // Q is sorted now: find the points back by their projection
+    V = malloc(h*sizeof(struct planarVertex));
+    polygon = malloc(h*sizeof(int));
+    if (V == NULL || polygon == NULL) goto cleanup;
+    for (int i=0; i<h; i++) {
+        V[i].x = Q[out[i]].x;
+        V[i].y = Q[out[i]].y;
+        V[i].slot = i;
+        polygon[i] = -1;
+    }
+    qsort(V, h, sizeof(struct planarVertex), cmpPlanar);
+    for (int k=0; k<m; k++) {
+        const point3 *q = PT(B, k);
+        struct planarVertex key = { (drop == 0 ? q->y : q->x), (drop == 2 ? q->y : q->z), 0 },
+                            *v = bsearch(&key, V, h, sizeof(struct planarVertex), cmpPlanar);
+        if (v != NULL && polygon[v->slot] == -1)
+            polygon[v->slot] = B->ids[k];
+    }
+
+    // Fan triangulation of both sides: face t on one side, h-2+t on the other
+    int t = h-2;
+    if (hull3Alloc(H, 2*t) < 0) goto cleanup;
+    for (int i=0; i<t; i++) {
+        int *front = &H->vertex[3*i], *back = &H->vertex[3*(t+i)];
+        int *frontTwin = &H->twin[3*i], *backTwin = &H->twin[3*(t+i)];
+        front[0] = back[0] = polygon[0];
+        front[1] = back[2] = polygon[i+1];
+        front[2] = back[1] = polygon[i+2];
+        frontTwin[0] = (i == 0 ? 3*t + 2 : 3*(i-1) + 2);
+        frontTwin[1] = 3*(t+i) + 1;
+        frontTwin[2] = (i == t-1 ? 3*(t+i) : 3*(i+1));
+        backTwin[0] = (i == t-1 ? 3*i + 2 : 3*(t+i+1) + 2);
+        backTwin[1] = 3*i + 1;
+        backTwin[2] = (i == 0 ? 0 : 3*(t+i-1));
+    }
+    faces = 2*t;
+
+cleanup:
+    free(Q);
+    free(out);
+    free(V);
+    free(polygon);
+    return faces;
+}
+
+/**
+ * Computes the convex hull of points in space.
+ * Collinear points and a single point have an empty hull (no faces).
+ * @param  Points A set of points (in space)
+ * @param  n      Number of points in Points
+ * @param  H      Receives the faces of the hull, to be released with
+ *                convexHull3dFree()
+ * @return        Number of faces of the hull, or -1 if out of memory
+ */
+int convexHull3d(const point3 *Points, int n, hull3 *H) {
+    int *ids = malloc(max(n, 1)*sizeof(int));
+    if (ids == NULL) {
+        H->faces = 0;
+        H->vertex = H->twin = NULL;
+        return -1;
+    }
+    for (int i=0; i<n; i++)
+        ids[i] = i;
+    int faces = hull3Build(Points, ids, n, H);
+    free(ids);
+    return faces;
+}
+
+/*
+ * Multi-threaded mode: each thread computes the hull of a chunk of the
+ * points, and the hull of the vertices of the chunk hulls is the hull of
+ * all points. For large clouds the chunk hulls are a small fraction of the
+ * points, so the last hull is cheap.
+ */
+
+#define PARALLEL3D_MAX_THREADS 64
+#define PARALLEL3D_MIN_POINTS 10000 // per thread
+
+struct chunk3Job {
+    const point3 *P;
+    const int *ids;
+    int m;
+    hull3 H;
+    int faces;
+};
+
+static void *chunk3Worker(void *arg) {
+    struct chunk3Job *job = arg;
+    job->faces = hull3Build(job->P, job->ids, job->m, &job->H);
+    return NULL;
+}
+
+/**
+ * Computes the convex hull of points in space using several threads.
+ * Same result as convexHull3d(), up to the triangulation of coplanar faces.
+ * @param  Points  A set of points (in space)
+ * @param  n       Number of points in Points
+ * @param  H       Receives the faces of the hull, to be released with
+ *                 convexHull3dFree()
+ * @param  threads Number of threads (and chunks) to use
+ * @return         Number of faces of the hull, or -1 if out of memory
+ */
+int convexHull3dParallel(const point3 *Points, int n, hull3 *H, int threads) {
+    threads = min(threads, min(PARALLEL3D_MAX_THREADS, n / PARALLEL3D_MIN_POINTS));
+    if (threads <= 1)
+        return convexHull3d(Points, n, H);
+
+    int faces = -1, *ids = malloc(n*sizeof(int));
+    char *isVertex = calloc(n, 1);
+    struct chunk3Job jobs[PARALLEL3D_MAX_THREADS];
+    pthread_t tids[PARALLEL3D_MAX_THREADS];
+    int started[PARALLEL3D_MAX_THREADS];
+    H->faces = 0;
+    H->vertex = H->twin = NULL;
+    if (ids == NULL || isVertex == NULL) goto cleanup;
+    for (int i=0; i<n; i++)
+        ids[i] = i;
+
+    for (int t=0; t<threads; t++) {
+        long long start = (long long)n*t/threads, end = (long long)n*(t+1)/threads;
+        jobs[t] = (struct chunk3Job){ Points, ids + start, end - start, { 0, NULL, NULL }, 0 };
+    }
+    for (int t=1; t<threads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, chunk3Worker, &jobs[t]) == 0);
+        if (!started[t])
+            chunk3Worker(&jobs[t]);
+    }
+    chunk3Worker(&jobs[0]);
+    for (int t=1; t<threads; t++)
+        if (started[t])
+            pthread_join(tids[t], NULL);
+
+    // Keep the vertices of the chunk hulls (all points of a flat chunk)
+    int m = 0, failed = false;
+    for (int t=0; t<threads; t++) {
+        if (jobs[t].faces < 0) failed = true;
+        if (jobs[t].faces > 0)
+            for (int i=0; i<3*jobs[t].faces; i++)
+                isVertex[jobs[t].H.vertex[i]] = true;
+        else
+            for (int i=0; i<jobs[t].m; i++)
+                isVertex[jobs[t].ids[i]] = true;
+        convexHull3dFree(&jobs[t].H);
+    }
+    if (failed) goto cleanup;
+    for (int i=0; i<n; i++)
+        if (isVertex[i])
+            ids[m++] = i;
+    faces = hull3Build(Points, ids, m, H);
+
+cleanup:
+    free(ids);
+    free(isVertex);
+    return faces;
+}
+
+void convexHull3dFree(hull3 *H) {
+    free(H->vertex);
+    free(H->twin);
+    H->faces = 0;
+    H->vertex = H->twin = NULL;
+}
+
+/*
+ * References:
+ * [BDH96] C. B. Barber, D. P. Dobkin, H. Huhdanpaa, The Quickhull algorithm
+ *         for convex hulls, ACM Transactions on Mathematical Software 22(4),
+ *         1996, 469-483.
+ */
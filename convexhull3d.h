@@ -0,0 +1,36 @@
+#ifndef __convexhull3d_h
+#define __convexhull3d_h
+
+#include "convexhull.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct point3 {
+    int x, y, z;
+} point3;
+
+/**
+ * Convex hull of points in space as a compact list of triangular faces:
+ * half-edge 3*f+i of face f goes from vertex[3*f+i] to vertex[3*f+(i+1)%3],
+ * the vertices of a face are counter-clockwise seen from outside, and
+ * twin[3*f+i] is the half-edge going the opposite way (in the face across).
+ * A planar point set has a flat hull: its polygon is triangulated twice, once
+ * for each side.
+ */
+typedef struct hull3 {
+    int faces;
+    int *vertex; // indices into the points, 3 per face
+    int *twin;   // 3 per face
+} hull3;
+
+int convexHull3d(const point3 *Points, int n, hull3 *H);
+int convexHull3dParallel(const point3 *Points, int n, hull3 *H, int threads);
+void convexHull3dFree(hull3 *H);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __convexhull3d_h */
@@ -0,0 +1,325 @@
+#include "dynamichull.h"
+#include "hullpart.h"
+#include <limits.h>
+
+/**
+ * Fully dynamic convex hull [OvL81]: points can be inserted and deleted in any
+ * order, each in O(log^3 n) time, and the hull is read in O(h log n) time.
+ *
+ * The leaves of the tree are the columns (distinct x coordinates) of the
+ * points, in x order. Only the smallest y of a column can be on the upper
+ * part (as in convexHullSorted()) and only the largest y on the lower part.
+ * For each part, an internal node stores the bridge between the parts of its
+ * two subtrees: the part of a subtree is then the part of its left subtree up
+ * to the left end of the bridge, followed by the part of its right subtree
+ * from the right end of the bridge. So the part of any subtree can be walked
+ * down from the root by narrowing a range [lo, hi] of x coordinates, and the
+ * bridge of a node is found by two nested binary searches on the parts of its
+ * subtrees. Unlike [OvL81] no concatenable queues are kept, which costs a
+ * factor log n on updates but needs nothing besides the bridges.
+ */
+
+// Index of a part (UPPER or LOWER, see hullpart.h) in per part arrays
+#define PART(side) ((side) == UPPER ? 0 : 1)
+
+// The points with the same x coordinate
+struct column {
+    RBTree *ys;    // y coordinates (with duplicates)
+    point upper;   // smallest y, the candidate for the upper part
+    point lower;   // largest y, the candidate for the lower part
+};
+
+// Bridge between the parts of the subtrees of an internal node (leaves)
+struct bridge {
+    RBLNode *left, *right;
+};
+
+#define isInternal(T, x) RBLhasLeft(T, x)
+
+static struct bridge *bridgeOf(RBLNode *x, int side) {
+    return &((struct bridge*)RBLaug(x))[PART(side)];
+}
+
+static const point *leafPoint(RBLNode *x, int side) {
+    struct column *c = x->data;
+    return (side == UPPER ? &c->upper : &c->lower);
+}
+
+// Sign of the cross product (q-p) x (s-r), exact for any int coordinates
+static int edgeCross(const point *p, const point *q, const point *r, const point *s) {
+    return crossSign((long long)q->x - p->x, (long long)q->y - p->y,
+                     (long long)s->x - r->x, (long long)s->y - r->y);
+}
+
+/**
+ * One step down the part of a subtree. At an internal node x, the part of x
+ * within [lo, hi] is the part of the left subtree within [lo, min(hi, l)]
+ * followed by the part of the right subtree within [max(lo, r), hi], where
+ * (l, r) is the bridge of x.
+ * @return  -1 or 1 if the part is only in the left or right subtree,
+ *          0 if the bridge is an edge of the part within [lo, hi]
+ */
+static int partSide(RBLNode *x, int side, int lo, int hi) {
+    struct bridge *b = bridgeOf(x, side);
+    if (b->right->key > hi) return -1;
+    if (b->left->key < lo) return 1;
+    return 0;
+}
+static RBLNode *goLeft(RBLNode *x, int side, int *hi) {
+    *hi = min(*hi, bridgeOf(x, side)->left->key);
+    return x->left;
+}
+static RBLNode *goRight(RBLNode *x, int side, int *lo) {
+    *lo = max(*lo, bridgeOf(x, side)->right->key);
+    return x->right;
+}
+
+/**
+ * Finds the vertex of the part of subtree x that is furthest from the line
+ * through a and b, on the outside of the part (the minimum of
+ * side*ccw(a, b, .), which decreases until the edges turn past b-a).
+ */
+static RBLNode *extremeLeaf(RBLTree *T, RBLNode *x, int side, const point *a, const point *b) {
+    int lo = INT_MIN, hi = INT_MAX;
+    while (isInternal(T, x)) {
+        int s = partSide(x, side, lo, hi);
+        if (s == 0) {
+            struct bridge *e = bridgeOf(x, side);
+            s = (side*edgeCross(a, b, leafPoint(e->left, side), leafPoint(e->right, side)) < 0 ? 1 : -1);
+        }
+        x = (s < 0 ? goLeft(x, side, &hi) : goRight(x, side, &lo));
+    }
+    return x;
+}
+
+/**
+ * Finds the tangent from q, to the left of all points of subtree x, to the
+ * part of x. Collinear vertices are skipped (the one furthest from q is used).
+ */
+static RBLNode *tangentFromLeft(RBLTree *T, RBLNode *x, int side, const point *q) {
+    int lo = INT_MIN, hi = INT_MAX;
+    while (isInternal(T, x)) {
+        int s = partSide(x, side, lo, hi);
+        if (s == 0) {
+            struct bridge *e = bridgeOf(x, side);
+            s = (side*ccw(q, leafPoint(e->left, side), leafPoint(e->right, side)) <= 0 ? 1 : -1);
+        }
+        x = (s < 0 ? goLeft(x, side, &hi) : goRight(x, side, &lo));
+    }
+    return x;
+}
+
+/**
+ * Computes the bridge of the internal node v, i.e. the edge of its part from
+ * a vertex p in the left subtree to a vertex in the right subtree, in
+ * O(log^2 n) time. An edge (a, b) of the left part is also on the part of v
+ * if and only if no vertex of the right part is on or outside its line, in
+ * which case p comes after a; otherwise p is a or before it.
+ */
+static void findBridge(RBLTree *T, RBLNode *v, int side) {
+    RBLNode *x = v->left;
+    int lo = INT_MIN, hi = INT_MAX;
+    while (isInternal(T, x)) {
+        int s = partSide(x, side, lo, hi);
+        if (s == 0) {
+            struct bridge *e = bridgeOf(x, side);
+            const point *a = leafPoint(e->left, side), *b = leafPoint(e->right, side);
+            RBLNode *w = extremeLeaf(T, v->right, side, a, b);
+            s = (side*ccw(a, b, leafPoint(w, side)) <= 0 ? -1 : 1);
+        }
+        x = (s < 0 ? goLeft(x, side, &hi) : goRight(x, side, &lo));
+    }
+    struct bridge *b = bridgeOf(v, side);
+    b->left = x;
+    b->right = tangentFromLeft(T, v->right, side, leafPoint(x, side));
+}
+
+// Augmentation of the tree: the bridges of both parts
+static void updateBridges(RBLTree *T, RBLNode *x) {
+    if (!isInternal(T, x)) return;
+    findBridge(T, x, UPPER);
+    findBridge(T, x, LOWER);
+}
+
+// The leaf of column x, or NULL
+static RBLNode *findColumn(RBLTree *T, int x) {
+    RBLNode *v = T->root;
+    if (RBLisEmpty(T)) return NULL;
+    while (isInternal(T, v))
+        v = (x <= v->key ? v->left : v->right);
+    return (v->key == x ? v : NULL);
+}
+
+// Updates the candidates of a column; true if they changed
+static int updateColumn(struct column *c) {
+    int upper = RBtreeMinimum(c->ys, c->ys->root)->key,
+        lower = RBtreeMaximum(c->ys, c->ys->root)->key,
+        changed = (upper != c->upper.y || lower != c->lower.y);
+    c->upper.y = upper;
+    c->lower.y = lower;
+    return changed;
+}
+
+static void freeColumn(struct column *c) {
+    if (c == NULL) return;
+    if (c->ys != NULL)
+        RBtreeDestroy(c->ys);
+    free(c);
+}
+
+/**
+ * Creates an empty dynamic hull.
+ * @return The hull, to be released with dynamicHullFree(), or NULL
+ */
+dynamicHull *dynamicHullInit(void) {
+    dynamicHull *H = malloc(sizeof(dynamicHull));
+    if (H == NULL) return NULL;
+    H->n = 0;
+    H->columns = RBLinit();
+    if (H->columns == NULL) {
+        free(H);
+        return NULL;
+    }
+    H->columns->augSize = 2*sizeof(struct bridge);
+    H->columns->augment = updateBridges;
+    return H;
+}
+
+/**
+ * Adds a point (duplicates are allowed) in O(log^3 n) time.
+ * @param  H The hull
+ * @param  p The new point
+ * @return   true on success, false if out of memory
+ */
+int dynamicHullInsert(dynamicHull *H, point p) {
+    RBLTree *T = H->columns;
+    RBNode *y = RBnewNode(p.y, NULL);
+    if (y == NULL) return false;
+    RBLNode *x = findColumn(T, p.x);
+    if (x == NULL) {
+        struct column *c = malloc(sizeof(struct column));
+        if (c == NULL || (c->ys = RBinit()) == NULL
+                || (x = RBLnewNode(p.x, c)) == NULL) {
+            if (c != NULL && c->ys != NULL) RBtreeDestroy(c->ys);
+            free(c);
+            free(y);
+            return false;
+        }
+        RBinsert(c->ys, y);
+        c->upper = c->lower = p;
+        RBLinsert(T, x);
+    } else {
+        struct column *c = x->data;
+        RBinsert(c->ys, y);
+        if (updateColumn(c))
+            RBLaugmentPath(T, x);
+    }
+    H->n++;
+    return true;
+}
+
+/**
+ * Removes one copy of a point in O(log^3 n) time.
+ * @param  H The hull
+ * @param  p The point to remove
+ * @return   true if p was removed, false if it is not in the hull
+ */
+int dynamicHullDelete(dynamicHull *H, point p) {
+    RBLTree *T = H->columns;
+    RBLNode *x = findColumn(T, p.x);
+    if (x == NULL) return false;
+    struct column *c = x->data;
+    RBNode *y = RBtreeSearchIterative(c->ys, c->ys->root, p.y);
+    if (RBisLeaf(c->ys, y)) return false;
+    RBdelete(c->ys, y);
+    free(y);
+    H->n--;
+    if (RBisEmpty(c->ys)) {
+        RBLdelete(T, x);
+        free(x);
+        freeColumn(c);
+    } else if (updateColumn(c)) {
+        RBLaugmentPath(T, x);
+    }
+    return true;
+}
+
+// Walks the part of subtree x within [lo, hi], in x order or reversed
+struct walk {
+    int side;
+    point *out;
+    int h;
+    RBLNode *skip[2]; // leaves that are already on the hull
+};
+static void walkPart(RBLTree *T, RBLNode *x, int lo, int hi, struct walk *w) {
+    if (!isInternal(T, x)) {
+        if (x->key < lo || x->key > hi || x == w->skip[0] || x == w->skip[1])
+            return;
+        if (w->out) w->out[w->h] = *leafPoint(x, w->side);
+        w->h++;
+        return;
+    }
+    struct bridge *b = bridgeOf(x, w->side);
+    int l = min(hi, b->left->key), r = max(lo, b->right->key);
+    if (w->side == UPPER) {
+        if (lo <= l) walkPart(T, x->left, lo, l, w);
+        if (r <= hi) walkPart(T, x->right, r, hi, w);
+    } else {
+        if (r <= hi) walkPart(T, x->right, r, hi, w);
+        if (lo <= l) walkPart(T, x->left, lo, l, w);
+    }
+}
+
+/**
+ * Reads the current hull in O(h log n) time, in the same order as
+ * convexHullIndices(): clockwise from the lexicographically smallest point.
+ * @param  H   The hull
+ * @param  out Receives the vertices of the hull, or NULL to only count them;
+ *             room for dynamicHullSize(H) points
+ * @return     Number of vertices of the hull
+ */
+int dynamicHullVertices(dynamicHull *H, point *out) {
+    RBLTree *T = H->columns;
+    if (RBLisEmpty(T)) return 0;
+    RBLNode *first = RBLtreeMinimum(T, T->root),
+            *last = RBLtreeMaximum(T, T->root);
+    struct walk w = { UPPER, out, 0, {NULL, NULL} };
+    walkPart(T, T->root, INT_MIN, INT_MAX, &w);
+    // The lower part, skipping the ends it shares with the upper part
+    struct column *a = first->data, *b = last->data;
+    w.side = LOWER;
+    if (b->upper.y == b->lower.y)
+        w.skip[0] = last;
+    if (a->upper.y == a->lower.y)
+        w.skip[1] = first;
+    walkPart(T, T->root, INT_MIN, INT_MAX, &w);
+    return w.h;
+}
+
+/**
+ * @return Number of vertices of the hull
+ */
+int dynamicHullSize(dynamicHull *H) {
+    return dynamicHullVertices(H, NULL);
+}
+
+void dynamicHullFree(dynamicHull *H) {
+    if (H == NULL) return;
+    RBLTree *T = H->columns;
+    T->augment = NULL; // no bridges needed while tearing down
+    if (!RBLisEmpty(T)) {
+        RBLNode *first = RBLtreeMinimum(T, T->root), *x = first;
+        do {
+            freeColumn(x->data);
+            x = x->next;
+        } while (x != first);
+    }
+    RBLtreeDestroy(T);
+    free(H);
+}
+
+/**
+ * [OvL81]
+ *   M. H. Overmars and J. van Leeuwen, "Maintenance of configurations in the
+ *   plane", Journal of Computer and System Sciences 23 (1981), 166-204.
+ */
@@ -0,0 +1,34 @@
+#ifndef __dynamichull_h
+#define __dynamichull_h
+
+#include "convexhull.h"
+#include "lib/rbtree.h"
+#include "lib/rbltree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Convex hull of a set of points under insertions and deletions.
+ * The distinct x coordinates are the leaves of a leaf oriented red-black tree,
+ * whose internal nodes store the bridges of the upper and lower part of the
+ * hull of their subtree (as in Overmars and van Leeuwen).
+ */
+typedef struct dynamicHull {
+    RBLTree *columns; // leaves are the points with the same x (a column)
+    int n;            // number of points
+} dynamicHull;
+
+dynamicHull *dynamicHullInit(void);
+int dynamicHullInsert(dynamicHull *H, point p);
+int dynamicHullDelete(dynamicHull *H, point p);
+int dynamicHullSize(dynamicHull *H);
+int dynamicHullVertices(dynamicHull *H, point *out);
+void dynamicHullFree(dynamicHull *H);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __dynamichull_h */
@@ -0,0 +1,76 @@
+#include "hullpart.h"
+
+/**
+ * A part of a hull kept in a red-black tree keyed by x, whose nodes hold the
+ * vertices of the part (in x order), shared by onlinehull.c and windowhull.c.
+ * An insertion is a logarithmic search for the neighbours of the new point,
+ * followed by popping the neighbours that are no longer vertices.
+ */
+
+point *partPoint(RBNode *x) {
+    return (point*)x->data;
+}
+
+// Removes a node from a part, logging it if there is a log
+static void removeVertex(RBTree *T, RBNode *x, const struct partNodes *nodes,
+                         RBNode **removed, int *removedSize) {
+    RBdelete(T, x);
+    if (removed != NULL)
+        removed[(*removedSize)++] = x;
+    else
+        nodes->drop(nodes->context, x);
+}
+
+/**
+ * Inserts p into one part of a hull.
+ * @param  T           The tree of the part
+ * @param  side        UPPER or LOWER
+ * @param  p           The new point
+ * @param  nodes       Gives the node of p and takes back the unused ones
+ * @param  removed     NULL, or logs the nodes removed from the part (to be
+ *                     inserted again on undo); room for all of them
+ * @param  removedSize Size of the log, counting the nodes logged here
+ * @return             The node of p, or NULL if p is not a vertex of the
+ *                     part (or out of memory)
+ */
+RBNode *insertPart(RBTree *T, int side, const point *p,
+                   const struct partNodes *nodes, RBNode **removed, int *removedSize) {
+    // Only the extreme point of an x coordinate can be on the part
+    RBNode *same = RBtreeSearchIterative(T, T->root, p->x);
+    if (!RBisLeaf(T, same)) {
+        int y = partPoint(same)->y;
+        if (side == UPPER ? y <= p->y : y >= p->y)
+            return NULL;
+        removeVertex(T, same, nodes, removed, removedSize);
+    }
+
+    RBNode *z = nodes->take(nodes->context, p);
+    if (z == NULL) return NULL;
+    RBinsert(T, z);
+
+    // p is not a vertex if it does not turn between its neighbours
+    RBNode *a = RBtreePredecessor(T, z),
+           *b = RBtreeSuccessor(T, z);
+    if (!RBisLeaf(T, a) && !RBisLeaf(T, b)
+            && side*ccw(partPoint(a), p, partPoint(b)) <= 0) {
+        RBdelete(T, z);
+        nodes->drop(nodes->context, z);
+        return NULL;
+    }
+    // Pop the neighbours that are no longer vertices
+    while (!RBisLeaf(T, a)) {
+        RBNode *a2 = RBtreePredecessor(T, a);
+        if (RBisLeaf(T, a2) || side*ccw(partPoint(a2), partPoint(a), p) > 0)
+            break;
+        removeVertex(T, a, nodes, removed, removedSize);
+        a = a2;
+    }
+    while (!RBisLeaf(T, b)) {
+        RBNode *b2 = RBtreeSuccessor(T, b);
+        if (RBisLeaf(T, b2) || side*ccw(p, partPoint(b), partPoint(b2)) > 0)
+            break;
+        removeVertex(T, b, nodes, removed, removedSize);
+        b = b2;
+    }
+    return z;
+}
@@ -0,0 +1,35 @@
+#ifndef __hullpart_h
+#define __hullpart_h
+
+#include "convexhull.h"
+#include "lib/rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parts of a hull, as built by convexHullSorted(): the upper part makes
+ * right turns (ccw > 0) from left to right, the lower part from right to
+ * left, and the lower part shares its ends with the upper part unless there
+ * is a vertical edge at that end. A side is the sign of ccw along its part.
+ */
+#define UPPER 1
+#define LOWER -1
+
+// Where insertPart() takes the node of a new vertex from, and returns it to
+struct partNodes {
+    RBNode *(*take)(void *context, const point *p); // NULL if out of memory
+    void (*drop)(void *context, RBNode *x);
+    void *context;
+};
+
+point *partPoint(RBNode *x);
+RBNode *insertPart(RBTree *T, int side, const point *p,
+                   const struct partNodes *nodes, RBNode **removed, int *removedSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __hullpart_h */
@@ -0,0 +1,467 @@
+#include "hullquery.h"
+
+/**
+ * Queries on a convex hull in O(log h) time:
+ *   - Containment: the lower and the upper chain of the hull have
+ *     increasing x, so a point is inside if it is within the x range of the
+ *     hull, left of the lower chain edge below it and right of the upper
+ *     chain edge above it. The x range of the hull is cut into equal
+ *     buckets that know their vertices of either chain, so finding the edges
+ *     is a search over the few vertices of one bucket (O(1) expected time,
+ *     O(log h) at worst).
+ *   - Extreme vertex in a direction: the outward normals of the edges turn
+ *     around once in order, and the vertex between the edges whose normals
+ *     enclose the direction is extreme. Normals are compared by pseudo-angle
+ *     (a monotone function of the angle, without trigonometry) and found
+ *     with buckets like the edges of a chain.
+ *   - Tangents: the edges visible from a point outside are one run of the
+ *     cyclic sequence of edges. Given one visible edge (the one failing the
+ *     containment test) and one invisible edge (next to the extreme vertex
+ *     in the direction away from the point), both ends of the run are found
+ *     by binary search.
+ * Orientation tests are done in double precision first, and by ccw() only
+ * when the determinant is within the error bound of orient2d() (see
+ * lib/predicates.h), so containment and tangents are exact. Extreme
+ * vertices are exact up to rounding of the dot products.
+ */
+
+#define QUERY_BLOCK 64 // queries searched before their orientation tests
+#define QUERY_BUCKETS 4 // buckets per vertex for finding the edge of a query
+#define QUERY_ERRBOUND CCW_ERRBOUND_A
+
+static point makePoint(int x, int y) {
+    point p = {0};
+    p.x = x;
+    p.y = y;
+    return p;
+}
+
+// Exact orientation of (C[j], C[j+1], q)
+static int chainOrientation(const struct hullChain *C, int j, int qx, int qy) {
+    point a = makePoint(C->x[j], C->y[j]), b = makePoint(C->x[j+1], C->y[j+1]),
+          q = makePoint(qx, qy);
+    return ccw(&a, &b, &q);
+}
+
+// Is edge i (from vertex i to i+1) visible from q, i.e. q strictly right of it?
+static int visible(const hullQuery *Q, int i, point q) {
+    point a = makePoint(Q->x[i], Q->y[i]), b = makePoint(Q->x[i+1], Q->y[i+1]);
+    return ccw(&a, &b, &q) < 0;
+}
+
+// Bucket of x, in 0..buckets-1 (nondecreasing in x)
+static inline int bucketOf(const hullQuery *Q, double x) {
+    double b = (x - Q->x[0]) * Q->scale;
+    return (int)(b < 0 ? 0 : b < Q->buckets - 1 ? b : Q->buckets - 1);
+}
+
+/*
+ * First edge j (from C[j] to C[j+1]) of a chain with C[j+1].x >= key, or the
+ * first or last edge outside the chain, i.e. the number of inner vertices
+ * 1..n-2 left of key. The inner vertices 1..lo are in buckets before the one
+ * of key, and lo+1..hi in it, so only these few vertices are searched.
+ */
+static inline int chainEdge(const struct hullChain *C, int lo, int hi, int key) {
+    // Most buckets have no more than one vertex
+    lo += (lo < hi) & (C->x[lo+1] < key);
+    while (hi - lo > 4) {
+        int mid = (lo + hi + 1) >> 1;
+        if (C->x[mid] < key) lo = mid;
+        else                 hi = mid - 1;
+    }
+    while (lo < hi && C->x[lo+1] < key)
+        lo++;
+    return lo;
+}
+
+static inline int lowerEdge(const hullQuery *Q, int key) {
+    int b = bucketOf(Q, key);
+    return chainEdge(&Q->lower, Q->bucket[b].lower, Q->bucket[b+1].lower, key);
+}
+
+static inline int upperEdge(const hullQuery *Q, int key) {
+    int b = bucketOf(Q, key);
+    return chainEdge(&Q->upper, Q->bucket[b].upper, Q->bucket[b+1].upper, key);
+}
+
+// Copies the vertices of a chain, dropping a vertical edge at either end
+static void buildChain(const hullQuery *Q, struct hullChain *C, const int *vertices, int n) {
+    int first = 0;
+    if (n > 2 && Q->x[vertices[0]] == Q->x[vertices[1]]) first = 1;
+    if (n - first > 2 && Q->x[vertices[n-2]] == Q->x[vertices[n-1]]) n--;
+    C->n = n - first;
+    for (int j=0; j<C->n; j++) {
+        C->vertex[j] = vertices[first + j];
+        C->x[j] = Q->x[C->vertex[j]];
+        C->y[j] = Q->y[C->vertex[j]];
+    }
+}
+
+// Counts the inner vertices of both chains in each bucket (prefix sums)
+static void buildBuckets(hullQuery *Q) {
+    Q->scale = Q->buckets / ((double)Q->x[Q->top] - Q->x[0] + 1);
+    memset(Q->bucket, 0, (Q->buckets+1)*sizeof(struct hullBucket));
+    for (int j=1; j<Q->lower.n-1; j++)
+        Q->bucket[bucketOf(Q, Q->lower.x[j]) + 1].lower++;
+    for (int j=1; j<Q->upper.n-1; j++)
+        Q->bucket[bucketOf(Q, Q->upper.x[j]) + 1].upper++;
+    for (int b=0; b<Q->buckets; b++) {
+        Q->bucket[b+1].lower += Q->bucket[b].lower;
+        Q->bucket[b+1].upper += Q->bucket[b].upper;
+    }
+}
+
+// Pseudo-angle of (dx, dy) in [0, 4), increasing with the angle from (1, 0)
+static inline double pseudoAngle(double dx, double dy) {
+    double p = dy / (fabs(dx) + fabs(dy));
+    return (dx < 0 ? 2 - p : dy < 0 ? 4 + p : p);
+}
+
+static inline int normalBucketOf(const hullQuery *Q, double angle) {
+    double b = angle * (Q->normalBuckets / 4.0);
+    return (int)(b < Q->normalBuckets - 1 ? b : Q->normalBuckets - 1);
+}
+
+// Sorts the edges into buckets by the pseudo-angles of their normals
+static void buildNormals(hullQuery *Q, double *angle) {
+    int n = Q->n;
+    Q->normalStart = 0;
+    for (int i=0; i<n; i++) {
+        // The hull is on the left of its edges, so (ey, -ex) points outwards
+        double ex = (double)Q->x[i+1] - Q->x[i], ey = (double)Q->y[i+1] - Q->y[i];
+        angle[i] = (n <= 2 ? 0 : pseudoAngle(ey, -ex));
+        if (angle[i] < angle[Q->normalStart]) Q->normalStart = i;
+    }
+    // The quadrant is exact, rounding within one may swap neighbours
+    for (int k=0; k<n; k++) {
+        Q->normal[k] = angle[(Q->normalStart + k) % n];
+        if (k > 0) Q->normal[k] = max(Q->normal[k], Q->normal[k-1]);
+    }
+    Q->normal[n] = 4; // beyond every direction
+    memset(Q->normalBucket, 0, (Q->normalBuckets+1)*sizeof(int));
+    for (int k=0; k<n; k++)
+        Q->normalBucket[normalBucketOf(Q, Q->normal[k]) + 1]++;
+    for (int b=0; b<Q->normalBuckets; b++)
+        Q->normalBucket[b+1] += Q->normalBucket[b];
+}
+
+/**
+ * Prepares a convex hull for queries.
+ * @param  Points A set of points (in the plane)
+ * @param  hull   Indices into Points of the vertices of CH(P) in order, as
+ *                returned by convexHullIndices() (either orientation)
+ * @param  h      Number of vertices, at least 1
+ * @return        The query structure, to be released with hullQueryFree(),
+ *                or NULL if memory is exhausted
+ */
+hullQuery *hullQueryInit(const point *Points, const int *hull, int h) {
+    if (h <= 0) return NULL;
+    hullQuery *Q = calloc(1, sizeof(hullQuery));
+    if (Q == NULL) return NULL;
+    Q->n = h;
+    Q->x = malloc((h+1)*sizeof(int));
+    Q->y = malloc((h+1)*sizeof(int));
+    Q->id = malloc(h*sizeof(int));
+    Q->normal = malloc((h+1)*sizeof(double));
+    struct hullChain *chains[2] = { &Q->lower, &Q->upper };
+    for (int c=0; c<2; c++) {
+        chains[c]->x = malloc((h+1)*sizeof(int));
+        chains[c]->y = malloc((h+1)*sizeof(int));
+        chains[c]->vertex = malloc((h+1)*sizeof(int));
+    }
+    Q->buckets = Q->normalBuckets = (h < INT_MAX / QUERY_BUCKETS ? QUERY_BUCKETS * h : h);
+    Q->bucket = malloc((Q->buckets+1)*sizeof(struct hullBucket));
+    Q->normalBucket = malloc((Q->normalBuckets+1)*sizeof(int));
+    int *vertices = malloc((h+1)*sizeof(int));
+    double *angle = malloc(h*sizeof(double));
+    if (Q->x == NULL || Q->y == NULL || Q->id == NULL || Q->normal == NULL
+            || Q->lower.x == NULL || Q->lower.y == NULL || Q->lower.vertex == NULL
+            || Q->upper.x == NULL || Q->upper.y == NULL || Q->upper.vertex == NULL
+            || Q->bucket == NULL || Q->normalBucket == NULL || vertices == NULL || angle == NULL) {
+        free(vertices);
+        free(angle);
+        hullQueryFree(Q);
+        return NULL;
+    }
+
+    // Start at the lexicographically smallest vertex, turning with ccw() > 0
+    int first = 0, dir = 1;
+    for (int i=1; i<h; i++)
+        if (comparePoints(&Points[hull[i]], &Points[hull[first]]) < 0)
+            first = i;
+    if (h >= 3 && ccw(&Points[hull[first]], &Points[hull[(first+1) % h]],
+                      &Points[hull[(first+2) % h]]) < 0)
+        dir = -1;
+    for (int i=0; i<h; i++) {
+        int k = hull[((first + dir*i) % h + h) % h];
+        Q->id[i] = k;
+        Q->x[i] = Points[k].x;
+        Q->y[i] = Points[k].y;
+        if (comparePoints(&Points[k], &Points[Q->id[Q->top]]) > 0)
+            Q->top = i;
+    }
+    Q->x[h] = Q->x[0];
+    Q->y[h] = Q->y[0];
+    buildNormals(Q, angle);
+    free(angle);
+
+    // The lower chain runs from the first vertex to the top one, and the
+    // upper chain back, so its vertices are taken in reverse
+    for (int i=0; i<=Q->top; i++)
+        vertices[i] = i;
+    buildChain(Q, &Q->lower, vertices, Q->top + 1);
+    vertices[0] = 0;
+    for (int i=1; i<=h-Q->top; i++)
+        vertices[i] = h - i;
+    buildChain(Q, &Q->upper, vertices, h - Q->top + 1);
+    free(vertices);
+    buildBuckets(Q);
+
+    // Any three vertices of a strictly convex polygon span its interior
+    Q->cx = ((double)Q->x[0] + Q->x[h/3] + Q->x[2*h/3]) / 3;
+    Q->cy = ((double)Q->y[0] + Q->y[h/3] + Q->y[2*h/3]) / 3;
+    return Q;
+}
+
+// Containment in a hull of one or two vertices
+static int containsSmall(const hullQuery *Q, int x, int y) {
+    point a = makePoint(Q->x[0], Q->y[0]), b = makePoint(Q->x[Q->n-1], Q->y[Q->n-1]),
+          q = makePoint(x, y);
+    return ccw(&a, &b, &q) == 0
+        && x >= min(a.x, b.x) && x <= max(a.x, b.x)
+        && y >= min(a.y, b.y) && y <= max(a.y, b.y);
+}
+
+/**
+ * Tests if points are inside of or on the hull, in blocks: the binary
+ * searches of a block come first, then the orientation tests of the block
+ * in double precision, and exact tests only for the undecided ones.
+ * @param  x, y   Coordinates of the points
+ * @param  count  Number of points
+ * @param  inside Receives 1 for each point inside of or on the hull, else 0
+ */
+void hullQueryContainsBatch(const hullQuery *Q, const int *x, const int *y, int count,
+                            unsigned char *inside) {
+    if (Q->n <= 2) {
+        for (int i=0; i<count; i++)
+            inside[i] = containsSmall(Q, x[i], y[i]);
+        return;
+    }
+    const struct hullChain *L = &Q->lower, *U = &Q->upper;
+    int xmin = Q->x[0], xmax = Q->x[Q->top];
+    int lo[QUERY_BLOCK], up[QUERY_BLOCK];
+    for (int start=0; start<count; start+=QUERY_BLOCK) {
+        int m = min(QUERY_BLOCK, count - start);
+        const int *qx = &x[start], *qy = &y[start];
+        unsigned char *in = &inside[start];
+        for (int i=0; i<m; i++) {
+            int b = bucketOf(Q, qx[i]);
+            lo[i] = chainEdge(L, Q->bucket[b].lower, Q->bucket[b+1].lower, qx[i]);
+            up[i] = chainEdge(U, Q->bucket[b].upper, Q->bucket[b+1].upper, qx[i]);
+        }
+        // 1 inside, 0 outside, 2 undecided (without branches)
+        for (int i=0; i<m; i++) {
+            int a = lo[i], b = up[i];
+            double px = qx[i], py = qy[i],
+                   ll = (L->x[a+1] - (double)L->x[a]) * (py - L->y[a]),
+                   lr = (L->y[a+1] - (double)L->y[a]) * (px - L->x[a]),
+                   ul = (U->x[b+1] - (double)U->x[b]) * (py - U->y[b]),
+                   ur = (U->y[b+1] - (double)U->y[b]) * (px - U->x[b]),
+                   dl = ll - lr, bl = QUERY_ERRBOUND * (fabs(ll) + fabs(lr)),
+                   du = ul - ur, bu = QUERY_ERRBOUND * (fabs(ul) + fabs(ur));
+            int outside = (qx[i] < xmin) | (qx[i] > xmax) | (dl < -bl) | (du > bu),
+                certain = (dl > bl) & (du < -bu);
+            in[i] = (unsigned char)(!outside * (2 - certain));
+        }
+        for (int i=0; i<m; i++)
+            if (in[i] == 2)
+                in[i] = (chainOrientation(L, lo[i], qx[i], qy[i]) >= 0
+                         && chainOrientation(U, up[i], qx[i], qy[i]) <= 0);
+    }
+}
+
+/**
+ * Tests if q is inside of or on the hull.
+ * @return 1 if it is, else 0
+ */
+int hullQueryContains(const hullQuery *Q, point q) {
+    unsigned char inside;
+    hullQueryContainsBatch(Q, &q.x, &q.y, 1, &inside);
+    return inside;
+}
+
+// The vertex after the last edge with a normal up to direction d, which is
+// extreme in d but for rounding of the pseudo-angles
+static int extremeSearch(const hullQuery *Q, double dx, double dy) {
+    int n = Q->n;
+    if (n <= 2 || (dx == 0 && dy == 0))
+        return (dx*Q->x[n-1] + dy*Q->y[n-1] > dx*Q->x[0] + dy*Q->y[0] ? n-1 : 0);
+    double angle = pseudoAngle(dx, dy);
+    int b = normalBucketOf(Q, angle), k = Q->normalBucket[b], last = Q->normalBucket[b+1];
+    k += (k < last) & (Q->normal[k] <= angle);
+    while (last - k > 4) {
+        int mid = (k + last) >> 1;
+        if (Q->normal[mid] <= angle) k = mid + 1;
+        else                         last = mid;
+    }
+    while (k < last && Q->normal[k] <= angle)
+        k++;
+    return (Q->normalStart + k) % n;
+}
+
+// The extreme vertex in direction d, from vertex v of extremeSearch()
+static int extremeClimb(const hullQuery *Q, int v, double dx, double dy) {
+    int n = Q->n;
+    if (n <= 2 || (dx == 0 && dy == 0))
+        return v;
+    // Rounded pseudo-angles may miss the extreme vertex by a little, but the
+    // dot products along the hull have a single maximum
+    double dot = dx*Q->x[v] + dy*Q->y[v];
+    for (int step=1; step>=-1; step-=2) {
+        for (;;) {
+            int w = (v + step + n) % n;
+            double next = dx*Q->x[w] + dy*Q->y[w];
+            if (!(next > dot)) break;
+            v = w;
+            dot = next;
+        }
+    }
+    return v;
+}
+
+// Index of the vertex with the largest dot product with d
+static int extremeVertex(const hullQuery *Q, double dx, double dy) {
+    return extremeClimb(Q, extremeSearch(Q, dx, dy), dx, dy);
+}
+
+/**
+ * Finds the vertices extreme in the directions d, with the largest dot
+ * product with d (ties are broken arbitrarily), in blocks: the searches of
+ * the normals of a block come first, then the corrections of their rounding.
+ * @param  dx, dy Coordinates of the directions
+ * @param  count  Number of directions
+ * @param  vertex Receives the index into the points of the hull of each
+ */
+void hullQueryExtremeBatch(const hullQuery *Q, const double *dx, const double *dy,
+                           int count, int *vertex) {
+    int v[QUERY_BLOCK];
+    for (int start=0; start<count; start+=QUERY_BLOCK) {
+        int m = min(QUERY_BLOCK, count - start);
+        for (int i=0; i<m; i++)
+            v[i] = extremeSearch(Q, dx[start+i], dy[start+i]);
+        for (int i=0; i<m; i++)
+            vertex[start+i] = Q->id[extremeClimb(Q, v[i], dx[start+i], dy[start+i])];
+    }
+}
+
+/**
+ * Finds the vertex extreme in direction d.
+ * @return Its index into the points of the hull
+ */
+int hullQueryExtreme(const hullQuery *Q, double dx, double dy) {
+    return Q->id[extremeVertex(Q, dx, dy)];
+}
+
+// An edge visible from q, or -1 if q is inside of or on the hull (n >= 3)
+static int visibleEdge(const hullQuery *Q, point q) {
+    int n = Q->n, top = Q->top;
+    // One of the edges at an extreme vertex in x is visible from beyond it
+    if (q.x < Q->x[0])
+        return (visible(Q, n-1, q) ? n-1 : 0);
+    if (q.x > Q->x[top])
+        return (visible(Q, top-1, q) ? top-1 : top);
+    // The upper chain is reversed, its edge j is edge vertex[j+1] of the hull
+    int e = Q->lower.vertex[lowerEdge(Q, q.x)];
+    if (visible(Q, e, q)) return e;
+    e = Q->upper.vertex[upperEdge(Q, q.x) + 1];
+    if (visible(Q, e, q)) return e;
+    return -1;
+}
+
+/**
+ * Finds the tangents from a point q outside of the hull, the vertices at
+ * which the hull is seen from q on the left and on the right (the lines
+ * from q through them have all of the hull on one side).
+ * @param  left, right Receive the indices of the vertices into the points of
+ *                     the hull, if q is outside
+ * @return             1 if q is outside of the hull, else 0
+ */
+int hullQueryTangents(const hullQuery *Q, point q, int *left, int *right) {
+    int n = Q->n;
+    if (n <= 2) {
+        if (containsSmall(Q, q.x, q.y)) return 0;
+        point a = makePoint(Q->x[0], Q->y[0]), b = makePoint(Q->x[n-1], Q->y[n-1]);
+        int swap = (ccw(&q, &a, &b) > 0);
+        *left = Q->id[swap ? n-1 : 0];
+        *right = Q->id[swap ? 0 : n-1];
+        return 1;
+    }
+    int s = visibleEdge(Q, q);
+    if (s < 0) return 0;
+
+    // An invisible edge at the vertex extreme away from q
+    int t = extremeVertex(Q, Q->cx - q.x, Q->cy - q.y);
+    if (visible(Q, t, q)) t = (t + n-1) % n;
+    // Rounded dot products may miss the extreme vertex by a little
+    while (visible(Q, t, q))
+        t = (t+1) % n;
+
+    // Going around from s to t, the visible edges come first
+    int lo = 0, hi = (t - s + n) % n;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (visible(Q, (s + mid) % n, q)) lo = mid;
+        else                              hi = mid;
+    }
+    *right = Q->id[(s + lo + 1) % n];
+    // Going around from t to s, the invisible edges come first
+    lo = 0, hi = (s - t + n) % n;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (visible(Q, (t + mid) % n, q)) hi = mid;
+        else                              lo = mid;
+    }
+    *left = Q->id[(t + hi) % n];
+    return 1;
+}
+
+/**
+ * Finds the tangents from many points, see hullQueryTangents(), in blocks:
+ * the points of a block inside of or on the hull are sorted out by
+ * hullQueryContainsBatch() first, and only the others are searched.
+ * @param  x, y        Coordinates of the points
+ * @param  count       Number of points
+ * @param  left, right Receive the tangent vertices of each point, or -1 for
+ *                     points inside of or on the hull
+ */
+void hullQueryTangentsBatch(const hullQuery *Q, const int *x, const int *y, int count,
+                            int *left, int *right) {
+    unsigned char inside[QUERY_BLOCK];
+    for (int start=0; start<count; start+=QUERY_BLOCK) {
+        int m = min(QUERY_BLOCK, count - start);
+        hullQueryContainsBatch(Q, &x[start], &y[start], m, inside);
+        for (int i=start; i<start+m; i++)
+            if (inside[i-start] || !hullQueryTangents(Q, makePoint(x[i], y[i]), &left[i], &right[i]))
+                left[i] = right[i] = -1;
+    }
+}
+
+/**
+ * Releases a query structure.
+ */
+void hullQueryFree(hullQuery *Q) {
+    if (Q == NULL) return;
+    free(Q->x);
+    free(Q->y);
+    free(Q->id);
+    free(Q->normal);
+    free(Q->normalBucket);
+    struct hullChain *chains[2] = { &Q->lower, &Q->upper };
+    for (int c=0; c<2; c++) {
+        free(chains[c]->x);
+        free(chains[c]->y);
+        free(chains[c]->vertex);
+    }
+    free(Q->bucket);
+    free(Q);
+}
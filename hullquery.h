@@ -0,0 +1,66 @@
+#ifndef __hullquery_h
+#define __hullquery_h
+
+#include "convexhull.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A chain of hull vertices with strictly increasing x, for containment
+struct hullChain {
+    int *x, *y;
+    int *vertex;  // index of each point into the vertices of the hull
+    int n;
+};
+
+// The inner vertices 1..lower of the lower chain, and 1..upper of the upper
+// chain, are in the buckets before this one
+struct hullBucket {
+    int lower, upper;
+};
+
+/**
+ * A convex hull prepared for queries in O(log h) time at worst: containment
+ * of points, tangents from points outside, and extreme vertices in a
+ * direction. The vertices are stored in contiguous arrays (structure of
+ * arrays) with bucket tables over x and over the angles of the edges, and
+ * the batched queries look up the edges of all queries of a block first,
+ * followed by the orientation tests of the whole block.
+ */
+typedef struct hullQuery {
+    int n;             // number of vertices
+    int *x, *y;        // vertices with ccw() > 0, from the lexicographically
+                       // smallest one, and x[n] = x[0], y[n] = y[0]
+    int *id;           // index of each vertex into the points of the hull
+    double *normal;    // pseudo-angles of the outward normals of the edges
+                       // (from vertex i to i+1), in order from that of edge
+                       // normalStart, and normal[n] = 4
+    int normalStart;
+    int *normalBucket; // normals before normalBucket[b] are in buckets before b
+    int normalBuckets;
+    int top;           // the lexicographically largest vertex
+    struct hullChain lower, upper;
+    struct hullBucket *bucket; // equal parts of the x range of the hull
+    int buckets;
+    double scale;              // buckets per unit of x
+    double cx, cy;     // a point strictly inside (n >= 3)
+} hullQuery;
+
+hullQuery *hullQueryInit(const point *Points, const int *hull, int h);
+int hullQueryContains(const hullQuery *Q, point q);
+void hullQueryContainsBatch(const hullQuery *Q, const int *x, const int *y, int count,
+                            unsigned char *inside);
+int hullQueryExtreme(const hullQuery *Q, double dx, double dy);
+void hullQueryExtremeBatch(const hullQuery *Q, const double *dx, const double *dy,
+                           int count, int *vertex);
+int hullQueryTangents(const hullQuery *Q, point q, int *left, int *right);
+void hullQueryTangentsBatch(const hullQuery *Q, const int *x, const int *y, int count,
+                            int *left, int *right);
+void hullQueryFree(hullQuery *Q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __hullquery_h */
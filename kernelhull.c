@@ -0,0 +1,280 @@
+#include "kernelhull.h"
+
+/**
+ * Epsilon-kernel by nearest neighbours of sites on a circle [BI76, AHV04]:
+ * The points lie in a disk of radius r around a center given in advance,
+ * and k sites are spread evenly on the circle of radius R = 2r around it.
+ * Each site keeps the point nearest to it. For a direction u, let p be the
+ * point extreme in u, y the point where the ray from p in direction u
+ * leaves the circle (at distance d >= R - |p| from p), and s the site
+ * nearest to y, e = s - y with |e| <= 2R sin(pi/2k). The point q kept by s
+ * is no farther from s than p, so
+ *     u.q >= u.s - |s - p| >= u.p - |e|^2 / 2d,
+ * and the hull of the kept points is within 2R^2 sin^2(pi/2k) / (R - |p|)
+ * of the exact hull, in every direction. For R = 2r this is at most
+ * 8r sin^2(pi/2k) < 2 pi^2 r / k^2, so k = O(1/sqrt(epsilon)) sites do.
+ *
+ * A point strictly inside the hull of the kept points is never extreme in
+ * any direction, so it is rejected without looking at the sites. After
+ * every block of points a disk and a box inside that hull are computed
+ * around the centroid of its vertices, and points in them are rejected by a
+ * few comparisons. Other points are tested against the edge of the hull at
+ * their (pseudo-)angle around the centroid, found in a table of the angles
+ * of the vertices. The distance of a point from the sites grows with the
+ * angle between them (seen from the center), so the remaining points visit
+ * the sites from the one at their angle outwards, until the distance
+ * exceeds that of every site from its point.
+ */
+
+#define PI 3.14159265358979323846
+#define KERNEL_BLOCK 4096 // points between updates of the inner disk and box
+
+/**
+ * Starts an approximate hull.
+ * @param  cx, cy  Center of a disk containing the points
+ * @param  radius  Its radius
+ * @param  epsilon Largest distance of the exact hull from the approximate
+ *                 one, relative to radius (in (0, 1])
+ * @return         The approximate hull, to be released with
+ *                 kernelHullFree(), or NULL if memory is exhausted
+ */
+kernelHull *kernelHullInit(double cx, double cy, double radius, double epsilon) {
+    kernelHull *K = calloc(1, sizeof(kernelHull));
+    if (K == NULL) return NULL;
+    epsilon = min(max(epsilon, 1e-12), 1.0);
+    // 8 sin^2(pi/2k) <= epsilon
+    K->sites = max(3, (int)ceil(PI / (2 * asin(sqrt(epsilon / 8)))));
+    K->cx = cx;
+    K->cy = cy;
+    K->radius = 2 * max(radius, 1.0);
+    K->sx = malloc(K->sites*sizeof(double));
+    K->sy = malloc(K->sites*sizeof(double));
+    K->nearest = malloc(K->sites*sizeof(point));
+    K->distance2 = malloc(K->sites*sizeof(double));
+    K->scratch = malloc(K->sites*sizeof(point));
+    K->indices = malloc((K->sites+1)*sizeof(int));
+    K->vertex = malloc(K->sites*sizeof(point));
+    K->angle = malloc(K->sites*sizeof(double));
+    K->wedges = 4 * K->sites;
+    K->wedge = malloc(K->wedges*sizeof(int));
+    if (K->sx == NULL || K->sy == NULL || K->nearest == NULL || K->distance2 == NULL
+            || K->scratch == NULL || K->indices == NULL || K->vertex == NULL
+            || K->angle == NULL || K->wedge == NULL) {
+        kernelHullFree(K);
+        return NULL;
+    }
+    for (int j=0; j<K->sites; j++) {
+        K->sx[j] = cx + K->radius * cos(2 * PI * j / K->sites);
+        K->sy[j] = cy + K->radius * sin(2 * PI * j / K->sites);
+        K->distance2[j] = HUGE_VAL;
+    }
+    K->farthest2 = HUGE_VAL;
+    K->inner2 = -1;
+    return K;
+}
+
+// Hull of the nearest points in scratch and indices, returns its size
+static int nearestHull(kernelHull *K) {
+    if (K->distance2[0] == HUGE_VAL) return 0;
+    memcpy(K->scratch, K->nearest, K->sites*sizeof(point));
+    return convexHullIndices(K->scratch, K->sites, K->indices);
+}
+
+// Pseudo-angle of (dx, dy) in [0, 4), increasing with the angle from (1, 0)
+static inline double pseudoAngle(double dx, double dy) {
+    double p = dy / (fabs(dx) + fabs(dy));
+    return (dx < 0 ? 2 - p : dy < 0 ? 4 + p : p);
+}
+
+// How far the hull of h vertices reaches from (ix, iy) in direction (dx, dy)
+static double reach(const kernelHull *K, int h, double dx, double dy) {
+    double t = HUGE_VAL;
+    for (int i=0; i<h; i++) {
+        const point *a = &K->scratch[K->indices[i]], *b = &K->scratch[K->indices[(i+1) % h]];
+        double ex = (double)b->x - a->x, ey = (double)b->y - a->y,
+               towards = ex*dy - ey*dx, // < 0 if the direction leaves by this edge
+               height = ex*(K->iy - a->y) - ey*(K->ix - a->x);
+        if (towards < 0) t = min(t, height / -towards);
+    }
+    return t;
+}
+
+// Updates the shapes inside the hull of the nearest points by which points
+// are rejected: a disk and a box around the centroid of its vertices, and
+// the vertices by angle around it
+static void updateInner(kernelHull *K) {
+    int h = nearestHull(K);
+    double inner = HUGE_VAL, x0 = HUGE_VAL, x1 = -HUGE_VAL, y0 = HUGE_VAL, y1 = -HUGE_VAL;
+    K->ix = K->iy = 0;
+    for (int i=0; i<h; i++) {
+        const point *v = &K->scratch[K->indices[i]];
+        K->ix += (double)v->x / h;
+        K->iy += (double)v->y / h;
+        x0 = min(x0, v->x);
+        x1 = max(x1, v->x);
+        y0 = min(y0, v->y);
+        y1 = max(y1, v->y);
+    }
+    for (int i=0; i<h && h>=3; i++) {
+        const point *a = &K->scratch[K->indices[i]], *b = &K->scratch[K->indices[(i+1) % h]];
+        double ex = (double)b->x - a->x, ey = (double)b->y - a->y,
+               // Distance of the centroid from the edge, positive on its inner side
+               d = (ex*(K->iy - a->y) - ey*(K->ix - a->x)) / sqrt(ex*ex + ey*ey);
+        inner = min(inner, d);
+    }
+    // A little smaller, so that rounding never rejects a point on the hull
+    inner *= 1 - 1e-9;
+    K->inner2 = (h >= 3 && inner > 0 ? inner*inner : -1);
+    K->vertices = (K->inner2 > 0 ? h : 0);
+
+    // The largest box of the proportions of the bounding box, by its corners
+    double w = (x1 - x0) / 2, t = HUGE_VAL;
+    for (int c=0; c<4 && K->vertices; c++)
+        t = min(t, reach(K, h, (c & 1 ? w : -w), (c & 2 ? (y1 - y0) / 2 : (y0 - y1) / 2)));
+    t = (K->vertices ? t * (1 - 1e-9) : 0);
+    K->boxX[0] = K->ix - t * w;
+    K->boxX[1] = K->ix + t * w;
+    K->boxY[0] = K->iy - t * (y1 - y0) / 2;
+    K->boxY[1] = K->iy + t * (y1 - y0) / 2;
+
+    // The vertices from the one of smallest angle, and the last one up to
+    // the start of each wedge
+    int first = 0;
+    for (int i=0; i<K->vertices; i++) {
+        const point *v = &K->scratch[K->indices[i]];
+        K->angle[i] = pseudoAngle(v->x - K->ix, v->y - K->iy);
+        if (K->angle[i] < K->angle[first]) first = i;
+    }
+    for (int i=0; i<K->vertices; i++)
+        K->vertex[i] = K->scratch[K->indices[(first + i) % h]];
+    for (int i=0; i<K->vertices; i++)
+        K->angle[i] = pseudoAngle(K->vertex[i].x - K->ix, K->vertex[i].y - K->iy);
+    for (int b=0, i=K->vertices-1; b<K->wedges && K->vertices; b++) {
+        double start = 4.0 * b / K->wedges;
+        if (i == K->vertices-1 && K->angle[0] <= start) i = 0;
+        while (i+1 < K->vertices && K->angle[i+1] <= start)
+            i++;
+        K->wedge[b] = i;
+    }
+    K->farthest2 = 0;
+    for (int j=0; j<K->sites; j++)
+        K->farthest2 = max(K->farthest2, K->distance2[j]);
+    K->changed = false;
+}
+
+// Is p strictly inside the hull of the nearest points at the last update?
+static int insideKernel(const kernelHull *K, const point *p) {
+    int h = K->vertices;
+    if (h < 3) return false;
+    double t = pseudoAngle(p->x - K->ix, p->y - K->iy);
+    int b = (int)(t * (K->wedges / 4.0)), i = K->wedge[min(max(b, 0), K->wedges-1)];
+    if (i == h-1 && K->angle[0] <= t) i = 0;
+    while (i+1 < h && K->angle[i+1] <= t)
+        i++;
+    // The edge from vertex i, and its neighbours in case t was rounded
+    for (int e=i+h-1; e<=i+h+1; e++)
+        if (ccw(&K->vertex[e % h], &K->vertex[(e+1) % h], p) <= 0)
+            return false;
+    return true;
+}
+
+// Takes p as the nearest point of site j if it is nearer, returns whether it
+// is nearer than farthest2 (or than any site to its point)
+static int nearerSite(kernelHull *K, const point *p, int j) {
+    double dx = p->x - K->sx[j], dy = p->y - K->sy[j], d2 = dx*dx + dy*dy;
+    if (d2 < K->distance2[j]) {
+        K->distance2[j] = d2;
+        K->nearest[j] = *p;
+        K->changed = true;
+    }
+    return d2 < K->farthest2;
+}
+
+// Visits the sites from the angle of p outwards in both directions
+static void nearestSites(kernelHull *K, const point *p) {
+    int k = K->sites;
+    double t = atan2(p->y - K->cy, p->x - K->cx) * k / (2 * PI);
+    int below = ((int)floor(t) % k + k) % k, steps = 0;
+    for (int j=below; steps<k && nearerSite(K, p, j); j=(j+k-1) % k)
+        steps++;
+    for (int j=(below+1) % k; steps<k && nearerSite(K, p, j); j=(j+1) % k)
+        steps++;
+}
+
+/**
+ * Adds points to the approximate hull.
+ * @param  Points A set of points (in the plane)
+ * @param  n      Number of points in Points
+ */
+void kernelHullAdd(kernelHull *K, const point *Points, int n) {
+    for (int start=0; start<n; start+=KERNEL_BLOCK) {
+        int m = min(KERNEL_BLOCK, n - start);
+        const point *P = &Points[start];
+        double maxRadius2 = K->maxRadius2, inner2 = K->inner2;
+        for (int i=0; i<m; i++) {
+            double px = P[i].x, py = P[i].y,
+                   r2 = (px - K->cx)*(px - K->cx) + (py - K->cy)*(py - K->cy),
+                   i2 = (px - K->ix)*(px - K->ix) + (py - K->iy)*(py - K->iy);
+            maxRadius2 = max(maxRadius2, r2);
+            if (i2 >= inner2 && !(px > K->boxX[0] && px < K->boxX[1] && py > K->boxY[0]
+                                  && py < K->boxY[1]) && !insideKernel(K, &P[i]))
+                nearestSites(K, &P[i]);
+        }
+        K->maxRadius2 = maxRadius2;
+        if (K->changed) updateInner(K);
+    }
+}
+
+/**
+ * Gets the vertices of the approximate hull, points of the stream.
+ * @param  out Receives the vertices in the order of convexHullIndices();
+ *             room for K->sites points (NULL only counts them)
+ * @return     Number of vertices
+ */
+int kernelHullVertices(kernelHull *K, point *out) {
+    int h = nearestHull(K);
+    for (int i=0; i<h && out!=NULL; i++)
+        out[i] = K->scratch[K->indices[i]];
+    return h;
+}
+
+/**
+ * Bound on the distance of any point of the exact hull from the approximate
+ * hull (their Hausdorff distance), for the points added so far, up to
+ * rounding. It is at most epsilon times the radius of kernelHullInit() if
+ * all points were within that radius.
+ * @return The bound, or HUGE_VAL if points were too far from the center
+ */
+double kernelHullError(const kernelHull *K) {
+    double R = K->radius, s = sin(PI / (2 * K->sites)),
+           farthest = sqrt(K->maxRadius2);
+    return (farthest < R ? 2 * R*R * s*s / (R - farthest) : HUGE_VAL);
+}
+
+/**
+ * Releases an approximate hull.
+ */
+void kernelHullFree(kernelHull *K) {
+    if (K == NULL) return;
+    free(K->sx);
+    free(K->sy);
+    free(K->nearest);
+    free(K->distance2);
+    free(K->scratch);
+    free(K->indices);
+    free(K->vertex);
+    free(K->angle);
+    free(K->wedge);
+    free(K);
+}
+
+
+/**
+ * [AHV04]
+ *     Pankaj K. Agarwal, Sariel Har-Peled and Kasturi R. Varadarajan,
+ *     "Approximating extent measures of points", Journal of the ACM 51 (2004)
+ *
+ * [BI76]
+ *     E. M. Bronshteyn and L. D. Ivanov, "The approximation of convex sets by
+ *     polyhedra", Siberian Mathematical Journal 16 (1976)
+ */
@@ -0,0 +1,49 @@
+#ifndef __kernelhull_h
+#define __kernelhull_h
+
+#include "convexhull.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Approximate convex hull (an epsilon-kernel) of a stream of points in one
+ * pass and O(1/sqrt(epsilon)) memory. Sites on a circle around the points
+ * each keep the point nearest to them, and the hull of these points is
+ * within distance epsilon times the radius of the points of the exact hull
+ * (see kernelHullError()).
+ */
+typedef struct kernelHull {
+    double cx, cy;     // center of the points
+    double radius;     // of the circle of sites (twice that of the points)
+    int sites;
+    double *sx, *sy;   // the sites
+    point *nearest;    // the point nearest to each site so far
+    double *distance2; // its squared distance
+    double farthest2;  // largest squared distance of a site from its point
+    double ix, iy;     // a point inside the kernel, and
+    double inner2;     // points nearer to it than this are inside as well,
+    double boxX[2], boxY[2]; // and points in this box
+    point *vertex;     // the hull of the nearest points, counterclockwise
+    double *angle;     // from the one of smallest angle around (ix, iy)
+    int vertices;
+    int *wedge;        // vertex of the largest angle up to each of wedges
+    int wedges;        // equal parts of the angles
+    double maxRadius2; // of all points from the center
+    int changed;       // a nearest point changed since inner2 was computed
+    point *scratch;    // room for the hull of the nearest points
+    int *indices;
+} kernelHull;
+
+kernelHull *kernelHullInit(double cx, double cy, double radius, double epsilon);
+void kernelHullAdd(kernelHull *K, const point *Points, int n);
+int kernelHullVertices(kernelHull *K, point *out);
+double kernelHullError(const kernelHull *K);
+void kernelHullFree(kernelHull *K);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __kernelhull_h */
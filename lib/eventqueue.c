@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <string.h>
+#include "eventqueue.h"
+
+/**
+ * B+ tree [Com79] used as a priority queue: insertion looks the key up (and
+ * coalesces the event with those already there) in O(log n) time, and the
+ * smallest key is at the front of the leftmost leaf. Nodes are split when
+ * full, but only the nodes on the leftmost path ever lose entries (to pops,
+ * which advance their first entry), so there is no merging of nodes: all
+ * other nodes stay at least half full and the height is O(log n).
+ * An internal node keeps the smallest key of each child at the time it was
+ * split off; the key of its first child is not used.
+ */
+
+#define EQ_KEYS_OFFSET ( (sizeof(EQNode) + EQ_ALIGN-1) / EQ_ALIGN * EQ_ALIGN )
+#define EQkey(Q, x, i) ( (void*)((char*)(x) + EQ_KEYS_OFFSET + (size_t)(i)*(Q)->keySize) )
+
+static void EQpoolInit(EQPool *P, size_t size) {
+    P->size = size;
+    P->free = NULL;
+    P->nfree = 0;
+    P->blocks = NULL;
+    P->nblocks = 0;
+    P->maxBlocks = 0;
+}
+
+// Makes sure that there are k free items
+static int EQpoolReserve(EQPool *P, size_t k) {
+    while (P->nfree < k) {
+        if (P->nblocks == P->maxBlocks) {
+            size_t max = (P->maxBlocks == 0 ? 16 : 2*P->maxBlocks);
+            void **blocks = realloc(P->blocks, max * sizeof(void*));
+            if (blocks == NULL) return -1;
+            P->blocks = blocks;
+            P->maxBlocks = max;
+        }
+        // Small queues take small blocks
+        int items = (P->nblocks < 6 ? (EQ_BLOCK >> 6) << P->nblocks : EQ_BLOCK);
+        char *block = malloc(items * P->size);
+        if (block == NULL) return -1;
+        P->blocks[P->nblocks++] = block;
+        for (int i=items-1; i>=0; i--) {
+            *(void**)(block + i*P->size) = P->free;
+            P->free = block + i*P->size;
+        }
+        P->nfree += items;
+    }
+    return 0;
+}
+
+// Takes a reserved item
+static void *EQpoolAlloc(EQPool *P) {
+    void *x = P->free;
+    P->free = *(void**)x;
+    P->nfree--;
+    return x;
+}
+
+static void EQpoolRelease(EQPool *P, void *x) {
+    *(void**)x = P->free;
+    P->free = x;
+    P->nfree++;
+}
+
+static void EQpoolDestroy(EQPool *P) {
+    for (size_t i=0; i<P->nblocks; i++)
+        free(P->blocks[i]);
+    free(P->blocks);
+}
+
+EventQueue *EQinit(size_t keySize, int (*compare)(const void *a, const void *b)) {
+    EventQueue *Q = malloc(sizeof(EventQueue));
+    if (Q == NULL) return NULL;
+    Q->root = NULL;
+    Q->size = 0;
+    Q->points = 0;
+    Q->keySize = keySize;
+    Q->compare = compare;
+    EQpoolInit(&Q->nodes, (EQ_KEYS_OFFSET + EQ_ORDER*keySize + EQ_ALIGN-1) / EQ_ALIGN * EQ_ALIGN);
+    EQpoolInit(&Q->events, sizeof(EQEvent));
+    Q->popped = NULL;
+    Q->maxPopped = 0;
+    return Q;
+}
+
+static EQNode *EQnewNode(EventQueue *Q, int leaf) {
+    EQNode *x = EQpoolAlloc(&Q->nodes);
+    x->leaf = leaf;
+    x->first = 0;
+    x->count = 0;
+    return x;
+}
+
+// Position of the last key not after key in x (x->first-1 if there is none)
+static int EQsearch(EventQueue *Q, EQNode *x, const void *key) {
+    int lo = x->first, hi = x->first + x->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (Q->compare(EQkey(Q, x, mid), key) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
+// Inserts an entry at position pos of x, which is not full
+static void EQplace(EventQueue *Q, EQNode *x, int pos, const void *key, void *slot) {
+    if (x->first + x->count == EQ_ORDER) {
+        memmove(&x->slot[0], &x->slot[x->first], x->count * sizeof(void*));
+        memmove(EQkey(Q, x, 0), EQkey(Q, x, x->first), x->count * Q->keySize);
+        pos -= x->first;
+        x->first = 0;
+    }
+    int end = x->first + x->count;
+    memmove(&x->slot[pos+1], &x->slot[pos], (end - pos) * sizeof(void*));
+    memmove(EQkey(Q, x, pos+1), EQkey(Q, x, pos), (end - pos) * Q->keySize);
+    x->slot[pos] = slot;
+    memcpy(EQkey(Q, x, pos), key, Q->keySize);
+    x->count++;
+}
+
+// Moves the upper half of the entries of x into a new node
+static EQNode *EQsplit(EventQueue *Q, EQNode *x) {
+    EQNode *y = EQnewNode(Q, x->leaf);
+    int half = x->count / 2, from = x->first + half;
+    y->count = x->count - half;
+    memcpy(&y->slot[0], &x->slot[from], y->count * sizeof(void*));
+    memcpy(EQkey(Q, y, 0), EQkey(Q, x, from), y->count * Q->keySize);
+    x->count = half;
+    return y;
+}
+
+/**
+ * Inserts an event.
+ * @param  key  Copied into the queue
+ * @param  data Of the event
+ * @return      0, or -1 if out of memory
+ */
+int EQinsert(EventQueue *Q, const void *key, void *data) {
+    // A node for each level that may split, and a new root
+    if (EQpoolReserve(&Q->events, 1) != 0 || EQpoolReserve(&Q->nodes, EQ_MAXHEIGHT+1) != 0)
+        return -1;
+    EQEvent *e = EQpoolAlloc(&Q->events);
+    e->data = data;
+    e->next = NULL;
+    if (Q->root == NULL)
+        Q->root = EQnewNode(Q, 1);
+    // Find the leaf, and the path to it
+    EQNode *path[EQ_MAXHEIGHT];
+    int at[EQ_MAXHEIGHT], depth = 0;
+    EQNode *x = Q->root;
+    while (!x->leaf) {
+        int pos = EQsearch(Q, x, key);
+        if (pos < x->first) pos = x->first;
+        path[depth] = x;
+        at[depth++] = pos;
+        x = x->slot[pos];
+    }
+    int pos = EQsearch(Q, x, key);
+    Q->size++;
+    if (pos >= x->first && Q->compare(EQkey(Q, x, pos), key) == 0) {
+        // Coalesce (the list is newest first)
+        e->next = x->slot[pos];
+        x->slot[pos] = e;
+        return 0;
+    }
+    Q->points++;
+
+    // Insert the entry, splitting full nodes up the path
+    void *slot = e;
+    pos++;
+    while (x->count == EQ_ORDER) {
+        EQNode *y = EQsplit(Q, x);
+        int boundary = x->first + x->count;
+        if (pos <= boundary)
+            EQplace(Q, x, pos, key, slot);
+        else
+            EQplace(Q, y, pos - boundary, key, slot);
+        key = EQkey(Q, y, y->first);
+        slot = y;
+        if (depth == 0) {
+            EQNode *r = EQnewNode(Q, 0);
+            EQplace(Q, r, 0, EQkey(Q, x, x->first), x);
+            EQplace(Q, r, 1, key, y);
+            Q->root = r;
+            return 0;
+        }
+        x = path[--depth];
+        pos = at[depth] + 1;
+    }
+    EQplace(Q, x, pos, key, slot);
+    return 0;
+}
+
+/**
+ * Removes all events at the smallest key.
+ * @param  key   Receives the key
+ * @param  count Receives the number of events
+ * @return       The data of the events in the order of insertion, valid
+ *               until the next EQpop(), or NULL if the queue is empty or
+ *               out of memory
+ */
+void **EQpop(EventQueue *Q, void *key, size_t *count) {
+    *count = 0;
+    if (Q->root == NULL) return NULL;
+    EQNode *path[EQ_MAXHEIGHT];
+    int depth = 0;
+    EQNode *x = Q->root;
+    while (!x->leaf) {
+        path[depth++] = x;
+        x = x->slot[x->first];
+    }
+    EQEvent *e = x->slot[x->first], *next;
+    size_t n = 0;
+    for (; e != NULL; e = e->next)
+        n++;
+    if (n > Q->maxPopped) {
+        size_t max = (2*Q->maxPopped > n ? 2*Q->maxPopped : n);
+        void **popped = realloc(Q->popped, max * sizeof(void*));
+        if (popped == NULL) return NULL;
+        Q->popped = popped;
+        Q->maxPopped = max;
+    }
+    memcpy(key, EQkey(Q, x, x->first), Q->keySize);
+    *count = n;
+    for (e = x->slot[x->first]; e != NULL; e = next) {
+        Q->popped[--n] = e->data; // the list is newest first
+        next = e->next;
+        EQpoolRelease(&Q->events, e);
+    }
+    Q->size -= *count;
+    Q->points--;
+
+    // Remove the entry, and the nodes left empty
+    x->first++;
+    x->count--;
+    while (x->count == 0) {
+        EQpoolRelease(&Q->nodes, x);
+        if (depth == 0) {
+            Q->root = NULL;
+            return Q->popped;
+        }
+        x = path[--depth];
+        x->first++;
+        x->count--;
+    }
+    while (!Q->root->leaf && Q->root->count == 1) {
+        x = Q->root;
+        Q->root = x->slot[x->first];
+        EQpoolRelease(&Q->nodes, x);
+    }
+    return Q->popped;
+}
+
+void EQdestroy(EventQueue *Q) {
+    EQpoolDestroy(&Q->nodes);
+    EQpoolDestroy(&Q->events);
+    free(Q->popped);
+    free(Q);
+}
+
+// Lexicographic (x, y) order of keys of two doubles
+int EQcomparePoints(const void *a, const void *b) {
+    const double *p = a, *q = b;
+    if (p[0] != q[0]) return (p[0] < q[0] ? -1 : 1);
+    return (p[1] > q[1]) - (p[1] < q[1]);
+}
+
+
+/**
+ * [Com79]
+ *     Douglas Comer, "The ubiquitous B-tree", ACM Computing Surveys 11 (1979)
+ */
@@ -0,0 +1,71 @@
+#ifndef __EVENTQUEUE_H
+#define __EVENTQUEUE_H
+
+/**
+ * Event queue of a sweep:
+ *   - A B+ tree of the keys (event points), whose leaves hold the events at
+ *     each key; an event is a data pointer.
+ *   - Keys are keySize bytes copied into the nodes, in the order of the
+ *     compare callback; EQcomparePoints() is the lexicographic (x, y) order
+ *     of two doubles. (Keys are aligned to EQ_ALIGN bytes if keySize is a
+ *     multiple of it.)
+ *   - Events at the same key are coalesced on insertion, and EQpop()
+ *     removes them all at once.
+ *   - Nodes and events come from pools that grow by blocks (of up to
+ *     EQ_BLOCK) and reuse what is popped, so there is no malloc per event.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EQ_ORDER 32      // entries of a node
+#define EQ_MAXHEIGHT 24  // nodes but the leftmost ones are half full at least
+#define EQ_BLOCK 4096
+#define EQ_ALIGN 16
+
+typedef struct EQEvent {
+    void *data;
+    struct EQEvent *next; // at the same key
+} EQEvent;
+typedef struct EQNode {
+    int leaf;
+    int first, count;     // the entries are first..first+count-1
+    void *slot[EQ_ORDER]; // children (with their smallest keys), or the
+                          // events at the keys (EQEvent lists)
+} EQNode;                 // followed by the EQ_ORDER keys
+typedef struct EQPool {
+    size_t size;          // of an item
+    void *free;           // linked through their first word
+    size_t nfree;
+    void **blocks;
+    size_t nblocks, maxBlocks;
+} EQPool;
+typedef struct EventQueue {
+    EQNode *root;
+    size_t size;          // number of events
+    size_t points;        // number of distinct keys
+    size_t keySize;
+    int (*compare)(const void *a, const void *b);
+    EQPool nodes, events;
+    // Data of the events popped last
+    void **popped;
+    size_t maxPopped;
+} EventQueue;
+
+// macros
+#define EQisEmpty(Q) ( (Q)->root == NULL )
+// common methods
+EventQueue *EQinit(size_t keySize, int (*compare)(const void *a, const void *b));
+int EQinsert(EventQueue *Q, const void *key, void *data);
+void **EQpop(EventQueue *Q, void *key, size_t *count);
+void EQdestroy(EventQueue *Q);
+int EQcomparePoints(const void *a, const void *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENTQUEUE_H */
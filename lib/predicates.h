@@ -0,0 +1,84 @@
+#ifndef __PREDICATES_H
+#define __PREDICATES_H
+
+/**
+ * Robust orientation predicate for floating point coordinates, after
+ * Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust
+ * Geometric Predicates" (1997):
+ *   - The determinant is computed in plain double precision first, and its
+ *     sign is returned right away when it is larger than the error bound.
+ *   - Only near-degenerate triples fall back to exact expansion arithmetic.
+ * Header only (static inline) so it can be used from C and C++ alike.
+ * NB: requires strict IEEE double arithmetic (no -ffast-math, no x87).
+ */
+
+#include <float.h>
+#include <math.h>
+
+// Half an ulp of 1.0 (Shewchuk's epsilon) and the bound of the fast path
+#define PRED_EPSILON (DBL_EPSILON / 2)
+#define CCW_ERRBOUND_A ((3.0 + 16.0 * PRED_EPSILON) * PRED_EPSILON)
+#define PRED_SPLITTER 134217729.0 // 2^27 + 1
+
+// a*b = x + y exactly
+static inline void predTwoProduct(double a, double b, double *x, double *y) {
+    *x = a * b;
+    double c = PRED_SPLITTER * a,
+           ahi = c - (c - a), alo = a - ahi;
+    c = PRED_SPLITTER * b;
+    double bhi = c - (c - b), blo = b - bhi;
+    *y = alo * blo - (((*x - ahi * bhi) - alo * bhi) - ahi * blo);
+}
+
+// Adds b to the nonoverlapping expansion e (of length n, smallest first)
+static inline int predGrowExpansion(double *e, int n, double b) {
+    int m = 0;
+    for (int i=0; i<n; i++) {
+        double x = b + e[i],
+               bv = x - b,
+               y = (b - (x - bv)) + (e[i] - bv);
+        if (y != 0.0)
+            e[m++] = y;
+        b = x;
+    }
+    if (b != 0.0)
+        e[m++] = b;
+    return m;
+}
+
+/**
+ * Exact sign of (bx-ax)*(cy-ay) - (by-ay)*(cx-ax), from the expansion of
+ * bx*cy - bx*ay - ax*cy - by*cx + by*ax + ay*cx (ax*ay cancels out).
+ */
+static inline double orient2dExact(const double *pa, const double *pb, const double *pc) {
+    const double terms[6][2] = {
+        { pb[0],  pc[1]}, {-pb[0],  pa[1]}, {-pa[0],  pc[1]},
+        {-pb[1],  pc[0]}, { pb[1],  pa[0]}, { pa[1],  pc[0]}
+    };
+    double e[12];
+    int n = 0;
+    for (int i=0; i<6; i++) {
+        double x, y;
+        predTwoProduct(terms[i][0], terms[i][1], &x, &y);
+        n = predGrowExpansion(e, n, y);
+        n = predGrowExpansion(e, n, x);
+    }
+    // The largest component carries the sign
+    return (n > 0 ? e[n-1] : 0.0);
+}
+
+/**
+ * Positive if pa, pb, pc is a counter-clockwise turn, negative if clockwise,
+ * and zero if collinear; the sign is always exact. The magnitude is roughly
+ * twice the signed area of the triangle.
+ */
+static inline double orient2d(const double *pa, const double *pb, const double *pc) {
+    double detleft = (pa[0] - pc[0]) * (pb[1] - pc[1]),
+           detright = (pa[1] - pc[1]) * (pb[0] - pc[0]),
+           det = detleft - detright;
+    if (fabs(det) >= CCW_ERRBOUND_A * (fabs(detleft) + fabs(detright)))
+        return det;
+    return orient2dExact(pa, pb, pc);
+}
+
+#endif /* __PREDICATES_H */
@@ -71,6 +71,29 @@ RBLNode *RBLtreePredecessor(RBLTree *T, RBLNode *x) {
     return RBLtreeMaximum(T, y->left);
 }
 
+/**
+ * Finds the first leaf whose data is not before data by T->compare.
+ * @param  T    A tree with a compare callback
+ * @param  data Compared as the first argument of T->compare
+ * @return      The leaf, or T->nil if every leaf is before data
+ */
+RBLNode *RBLtreeLowerBound(RBLTree *T, const void *data) {
+    RBLNode *x = T->root;
+    if (x == T->nil) return T->nil;
+    int wentLeft = 0;
+    while (RBLhasLeft(T, x)) {
+        if (T->compare(T, data, x->sep->data) <= 0) {
+            x = x->left;
+            wentLeft = 1;
+        } else
+            x = x->right;
+    }
+    if (T->compare(T, data, x->data) <= 0)
+        return x;
+    // x is the largest leaf of a left subtree, or the maximum
+    return (wentLeft ? x->next : T->nil);
+}
+
 
 // Common methods
 RBLTree *RBLinit() {
@@ -86,6 +109,10 @@ RBLTree *RBLinit() {
     if (T == NULL) return NULL;
     T->nil = nil;
     T->root = nil;
+    T->augSize = 0;
+    T->augment = NULL;
+    T->compare = NULL;
+    T->ctx = NULL;
     return T;
 }
 
@@ -97,12 +124,39 @@ RBLNode *RBLnewNode(int key, void *data) {
     return x;
 }
 
+// Internal nodes have room for the augmented data
+static RBLNode *RBLnewInternalNode(RBLTree *T, int key) {
+    RBLNode *x = malloc(sizeof(RBLNode) + T->augSize);
+    if (x == NULL) return NULL;
+    x->key = key;
+    x->data = NULL;
+    return x;
+}
+
+/**
+ * Recomputes the augmented data of the internal nodes from x to the root.
+ * Has to be called when the data of a leaf changes in a way that matters to
+ * the augmentation; insertions and deletions do this by themselves.
+ */
+void RBLaugmentPath(RBLTree *T, RBLNode *x) {
+    if (T->augment == NULL) return;
+    for (x = (RBLhasLeft(T, x) ? x : x->p); x != T->nil; x = x->p)
+        T->augment(T, x);
+}
+
+// Does leaf z go before node x (a leaf, or internal with its sep)?
+static int RBLbefore(RBLTree *T, RBLNode *z, RBLNode *x) {
+    if (T->compare == NULL)
+        return z->key < x->key;
+    return T->compare(T, z->data, (RBLhasLeft(T, x) ? x->sep : x)->data) < 0;
+}
+
 void RBLinsert(RBLTree *T, RBLNode *z) {
     RBLNode *y = T->nil;
     RBLNode *x = T->root;
     while (x != T->nil) {
         y = x;
-        if (z->key < x->key)
+        if (RBLbefore(T, z, x))
             x = x->left;
         else
             x = x->right;
@@ -117,7 +171,8 @@ void RBLinsert(RBLTree *T, RBLNode *z) {
         z->prev = z;
     } else {
         // Create new internal node with y's data
-        RBLNode *u = RBLnewNode(y->key, NULL);
+        RBLNode *u = RBLnewInternalNode(T, y->key);
+        u->sep = y;
         if (y == T->root) {
             T->root = u;
             u->p = T->nil;
@@ -133,10 +188,11 @@ void RBLinsert(RBLTree *T, RBLNode *z) {
         y->p = u;
         z->p = u;
 
-        if (z->key < y->key) {      // z shall be a left child
+        if (RBLbefore(T, z, y)) {   // z shall be a left child
             u->left = z;
             u->right = y;
             u->key = z->key;
+            u->sep = z;
             // Maintain list-pointers
             z->prev = RBLtreePredecessor(T, z);
             z->prev->next = z;
@@ -157,30 +213,47 @@ void RBLinsert(RBLTree *T, RBLNode *z) {
         }
         u->color = y->color;
         y->color = RED;
+        // u needs valid augmented data before any rotation involves it
+        if (T->augment)
+            T->augment(T, u);
     }
     z->color = RED;
     RBLinsertFixup(T, z);
+    RBLaugmentPath(T, z);
 }
 
 void RBLdelete(RBLTree *T, RBLNode *z) {
+    // The internal node whose left subtree has z as its maximum takes the
+    // key of the predecessor, so its key still separates the subtrees
+    RBLNode *x = z;
+    while (x->p != T->nil && x == x->p->right)
+        x = x->p;
+    if (x->p != T->nil && x->p != z->p) {
+        if (T->compare == NULL ? x->p->key == z->key : x->p->sep == z) {
+            x->p->key = z->prev->key;
+            x->p->sep = z->prev;
+        }
+    }
     // Maintain list-pointers
     z->prev->next = z->next;
     z->next->prev = z->prev;
     // NOTE: z is always a leaf
     if (z->p == T->nil) {
         T->root = T->nil;
-    } else if (z == z->p->left) {   // z is a left child
+        return;
+    }
+    RBLNode *sibling;
+    if (z == z->p->left) {          // z is a left child
+        sibling = z->p->right;
         z->p->left = T->nil;
-        // Sibling is replaced with parent
-        RBLdeleteInternal(T, z->p);
-        free(z->p);
     } else {                        // z is a right child
+        sibling = z->p->left;
         z->p->right = T->nil;
-        // Sibling is replaced with parent
-        RBLdeleteInternal(T, z->p);
-        free(z->p);
-        // TODO: maybe have to do something here regarding key update
     }
+    // Sibling is replaced with parent
+    RBLdeleteInternal(T, z->p);
+    free(z->p);
+    RBLaugmentPath(T, sibling);
 }
 
 
@@ -199,6 +272,10 @@ void RBLleftRotate(RBLTree *T, RBLNode *x) {
         x->p->right = y;
     y->left = x;
     x->p = y;
+    if (T->augment) {
+        T->augment(T, x);
+        T->augment(T, y);
+    }
 }
 void RBLrightRotate(RBLTree *T, RBLNode *y) {
     RBLNode *x = y->left;
@@ -214,6 +291,10 @@ void RBLrightRotate(RBLTree *T, RBLNode *y) {
         y->p->right = x;
     x->right = y;
     y->p = x;
+    if (T->augment) {
+        T->augment(T, y);
+        T->augment(T, x);
+    }
 }
 void RBLinsertFixup(RBLTree *T, RBLNode *z) {
     RBLNode *y;
@@ -6,11 +6,24 @@
  *   - Data are stored in the leaves of the tree.
  *   - The leaves are also a doubly linked list with
  *     pointers to successor/predecessor leaves.
+ *   - Internal nodes can be augmented with augSize bytes of extra data
+ *     (see RBLaug()), kept up to date by the augment callback: it is called
+ *     on every internal node whose subtree changes, children before parents.
+ *   - The leaves are ordered by their int keys, or by their data if the tree
+ *     has a compare callback: an order that may depend on T->ctx, as long as
+ *     the leaves already in the tree stay sorted by it (e.g. a sweep line).
+ *     Internal nodes then compare by sep, the largest leaf of their left
+ *     subtree.
  */
 
+#include <stddef.h>
 #include "util.h"
 
-typedef enum {RED, BLACK} RBLColor;
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef RBColor RBLColor;
 
 typedef struct RBLNode {
     int key;
@@ -20,11 +33,18 @@ typedef struct RBLNode {
     struct RBLNode *right;
     struct RBLNode *prev;
     struct RBLNode *next;
+    struct RBLNode *sep; // internal nodes: largest leaf of the left subtree
     RBLColor color;
 } RBLNode;
 typedef struct RBLTree {
     struct RBLNode *root;
     RBLNode *nil;
+    // Augmentation of internal nodes (none by default)
+    size_t augSize;
+    void (*augment)(struct RBLTree *T, RBLNode *x);
+    // Order of the leaves by their data (NULL: by their keys)
+    int (*compare)(struct RBLTree *T, const void *a, const void *b);
+    void *ctx; // for use by augment and compare
 } RBLTree;
 
 // macros
@@ -34,6 +54,7 @@ typedef struct RBLTree {
 #define RBLhasColor(x, col) ( (x)->color == col )
 #define RBLisEmpty(T) ( (T)->root == (T)->nil )
 #define RBLhasData(x) ( (x)->data != NULL )
+#define RBLaug(x) ( (void*)((x)+1) ) // augmented data of an internal node
 // Search tree operations
 RBLNode *RBLtreeSearch(RBLTree *T, int k);
 RBLNode *RBLtreeSearchIterative(RBLTree *T, int k);
@@ -41,11 +62,13 @@ RBLNode *RBLtreeMinimum(RBLTree *T, RBLNode *x);
 RBLNode *RBLtreeMaximum(RBLTree *T, RBLNode *x);
 RBLNode *RBLtreeSuccessor(RBLTree *T, RBLNode *x);
 RBLNode *RBLtreePredecessor(RBLTree *T, RBLNode *x);
+RBLNode *RBLtreeLowerBound(RBLTree *T, const void *data);
 // common methods
 RBLTree *RBLinit();
 RBLNode *RBLnewNode(int key, void *data);
 void RBLinsert(RBLTree *T, RBLNode *z);
 void RBLdelete(RBLTree *T, RBLNode *z);
+void RBLaugmentPath(RBLTree *T, RBLNode *x);
 // testing methods
 int RBLeachLeafIsBlack(RBLTree *T);
 int RBLeachRedNodeHasBlackChildren(RBLTree *T);
@@ -57,4 +80,8 @@ void RBLwriteTree(RBLTree *T, char *filename);
 void RBLdestroy(RBLTree *T, RBLNode *x);
 void RBLtreeDestroy(RBLTree *T);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* __RBLTREE_H */
\ No newline at end of file
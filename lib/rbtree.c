@@ -416,3 +416,18 @@ void RBwriteTree(RBTree *T, char *filename) {
     fprintf(fd, "}\n");
     fclose(fd);
 }
+
+static void RBsubtreeDestroy(RBTree *T, RBNode *x) {
+    if (RBisLeaf(T, x))
+        return;
+    RBsubtreeDestroy(T, x->left);
+    RBsubtreeDestroy(T, x->right);
+    free(x);
+}
+
+// Frees the tree and its nodes, but not the data of the nodes
+void RBtreeDestroy(RBTree *T) {
+    RBsubtreeDestroy(T, T->root);
+    free(T->nil);
+    free(T);
+}
@@ -1,7 +1,7 @@
 #ifndef __RBTREE_H
 #define __RBTREE_H
 
-typedef enum {RED, BLACK} RBColor;
+#include "util.h"
 
 typedef struct RBNode {
     int key;
@@ -42,5 +42,6 @@ int RBeachRootLeafPathHasEqualLength(RBTree *T);
 int RBisRBTree(RBTree *T);
 // miscelanous
 void RBwriteTree(RBTree *T, char *filename);
+void RBtreeDestroy(RBTree *T);
 
 #endif /* __RBTREE_H */
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 
+// Node colors of the red-black trees (rbtree.h and rbltree.h)
+typedef enum {RED, BLACK} RBColor;
+
 #define DO_PRAGMA(x) _Pragma (#x)
 #define TODO(x) DO_PRAGMA(message ("TODO - " #x))
 // Usage:
@@ -0,0 +1,139 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/eventqueue.h"
+#include "../lib/rbtree.h"
+
+/**
+ * Event queue benchmark: the same stream of events through an EventQueue
+ * and through an RBTree with int keys (x*2^16 + y), one malloc'd node per
+ * point and one malloc'd list cell per event to coalesce them.
+ * Half of the events are inserted up front (the endpoints of a sweep), and
+ * every pop of the first half inserts one more event a little to the right
+ * of the popped point (an intersection), until there are N events in all.
+ * Points are on a 2^15 x 2^16 grid, so many events coincide.
+ *
+ * Usage: eventqueue_bench [-N events]
+ */
+
+#define GRID_X 32768
+#define GRID_Y 65536
+#define AHEAD 64
+
+#define getTimeDiff(te, ts) ((double)(te - ts) / CLOCKS_PER_SEC)
+
+// Deterministic, so both queues see the same stream
+static unsigned long long state;
+static unsigned random32(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (unsigned)(state >> 16);
+}
+
+struct result {
+    long points;           // number of pops
+    unsigned long long sum; // checksum of the points and their event counts
+    double seconds;
+};
+
+static void eventQueueRun(long N, struct result *r) {
+    clock_t start = clock();
+    EventQueue *Q = EQinit(2*sizeof(double), EQcomparePoints);
+    state = 88172645463325252ULL;
+    long inserted = 0;
+    for (; inserted < N/2; inserted++) {
+        double p[2] = { random32() % GRID_X, random32() % GRID_Y };
+        EQinsert(Q, p, NULL);
+    }
+    r->points = 0;
+    r->sum = 0;
+    while (!EQisEmpty(Q)) {
+        double p[2];
+        size_t count;
+        EQpop(Q, p, &count);
+        r->points++;
+        r->sum = r->sum*31 + (unsigned long long)p[0]*GRID_Y + (unsigned long long)p[1] + count;
+        if (inserted < N) {
+            double q[2] = { p[0] + random32() % AHEAD, random32() % GRID_Y };
+            EQinsert(Q, q, NULL);
+            inserted++;
+        }
+    }
+    EQdestroy(Q);
+    r->seconds = getTimeDiff(clock(), start);
+}
+
+struct cell {
+    struct cell *next;
+};
+
+static void rbTreeInsert(RBTree *T, int key) {
+    struct cell *c = malloc(sizeof(struct cell));
+    RBNode *x = RBtreeSearchIterative(T, T->root, key);
+    if (x != T->nil) {
+        c->next = x->data;
+        x->data = c;
+    } else {
+        c->next = NULL;
+        RBinsert(T, RBnewNode(key, c));
+    }
+}
+
+static void rbTreeRun(long N, struct result *r) {
+    clock_t start = clock();
+    RBTree *T = RBinit();
+    state = 88172645463325252ULL;
+    long inserted = 0;
+    for (; inserted < N/2; inserted++) {
+        int x = random32() % GRID_X, y = random32() % GRID_Y;
+        rbTreeInsert(T, x*GRID_Y + y);
+    }
+    r->points = 0;
+    r->sum = 0;
+    while (!RBisEmpty(T)) {
+        RBNode *x = RBtreeMinimum(T, T->root);
+        size_t count = 0;
+        for (struct cell *c = x->data, *next; c != NULL; c = next) {
+            next = c->next;
+            free(c);
+            count++;
+        }
+        int key = x->key;
+        RBdelete(T, x);
+        free(x);
+        r->points++;
+        r->sum = r->sum*31 + (unsigned long long)key + count;
+        if (inserted < N) {
+            int qx = key / GRID_Y + random32() % AHEAD, qy = random32() % GRID_Y;
+            rbTreeInsert(T, qx*GRID_Y + qy);
+            inserted++;
+        }
+    }
+    RBtreeDestroy(T);
+    r->seconds = getTimeDiff(clock(), start);
+}
+
+int main(int argc, char **argv) {
+    long N = 10000000;
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-N") == 0 && i+1 < argc)
+            N = atof(argv[++i]);
+        else {
+            printf("Usage: %s [-N events]\n", argv[0]);
+            return 1;
+        }
+    }
+    struct result eq, rb;
+    eventQueueRun(N, &eq);
+    rbTreeRun(N, &rb);
+    printf("%ld events at %ld points:\n", N, eq.points);
+    printf("\tEventQueue: %8.3f sec\n", eq.seconds);
+    printf("\tRBTree:     %8.3f sec (%.2fx)\n", rb.seconds, rb.seconds / eq.seconds);
+    if (eq.points != rb.points || eq.sum != rb.sum) {
+        printf("ERROR: the queues popped different events\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../lib/eventqueue.h"
+
+#define RUNS 50
+#define OPERATIONS 4000
+#define LARGE 300000
+
+#define THEAD(desc) printf("\ttest: %-40s", desc)
+#define TFOOT(ok) printf("\t      => %s\n", (ok?"SUCCESS":"FAIL"))
+
+// An event of the reference: a list in the order of insertion
+struct reference {
+    double p[2];
+    int popped;
+};
+
+/**
+ * Random insertions and pops on a small grid (many events at the same
+ * point, and points before the ones popped already), against a list.
+ * Success: if every pop returns the smallest point with all of its events
+ * in the order of insertion
+ */
+int test_order(void) {
+    THEAD("Insert and pop against a list");
+    int ok = 1;
+    struct reference *R = malloc(OPERATIONS * sizeof(struct reference));
+    for (int run=0; run<RUNS && ok; run++) {
+        EventQueue *Q = EQinit(2*sizeof(double), EQcomparePoints);
+        int grid = (run % 2 ? 8 : 1000), n = 0, left = 0;
+        for (int op=0; op<OPERATIONS && ok; op++) {
+            if (rand() % 5 < 3) {
+                R[n].p[0] = rand() % grid;
+                R[n].p[1] = rand() % grid;
+                R[n].popped = 0;
+                ok &= (EQinsert(Q, R[n].p, &R[n]) == 0);
+                n++;
+                left++;
+            } else {
+                double p[2];
+                size_t count;
+                void **events = EQpop(Q, p, &count);
+                ok &= ((events == NULL) == (left == 0));
+                if (left == 0) continue;
+                int min = -1;
+                for (int i=0; i<n; i++)
+                    if (!R[i].popped && (min < 0 || EQcomparePoints(R[i].p, R[min].p) < 0))
+                        min = i;
+                size_t k = 0;
+                for (int i=min; i<n && ok; i++) {
+                    if (R[i].popped || EQcomparePoints(R[i].p, R[min].p) != 0)
+                        continue;
+                    ok &= (k < count && events[k++] == &R[i]);
+                    R[i].popped = 1;
+                    left--;
+                }
+                ok &= (k == count && EQcomparePoints(p, R[min].p) == 0);
+            }
+            ok &= (Q->size == (size_t)left);
+        }
+        EQdestroy(Q);
+    }
+    free(R);
+    TFOOT(ok);
+    return ok;
+}
+
+/**
+ * Many events on a grid, all inserted and then popped.
+ * Success: if the points come out in increasing order, each once, with all
+ * of the events
+ */
+int test_large(void) {
+    THEAD("Coalescing of many events");
+    int ok = 1, grid = 256;
+    EventQueue *Q = EQinit(2*sizeof(double), EQcomparePoints);
+    char *seen = calloc(grid*grid, 1);
+    int points = 0;
+    for (int i=0; i<LARGE; i++) {
+        double p[2] = { rand() % grid, rand() % grid };
+        points += !seen[(int)p[0]*grid + (int)p[1]];
+        seen[(int)p[0]*grid + (int)p[1]] = 1;
+        ok &= (EQinsert(Q, p, NULL) == 0);
+    }
+    ok &= (Q->points == (size_t)points);
+    double last[2] = { -1, -1 };
+    size_t total = 0;
+    while (!EQisEmpty(Q) && ok) {
+        double p[2];
+        size_t count;
+        EQpop(Q, p, &count);
+        ok &= (EQcomparePoints(last, p) < 0);
+        last[0] = p[0];
+        last[1] = p[1];
+        total += count;
+        points--;
+    }
+    ok &= (total == LARGE && points == 0 && Q->size == 0);
+    EQdestroy(Q);
+    free(seen);
+    TFOOT(ok);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int tests = 0, succeses = 0;
+    printf("===============================\n");
+    printf("Testing:\n");
+    tests++; succeses += test_order();
+    tests++; succeses += test_large();
+    printf("===============================\n");
+    printf("Performed %3d tests:\n", tests);
+    printf("\t  %3d failures\n", tests-succeses);
+    printf("\t  %3d succeses\n", succeses);
+    return (tests != succeses);
+}
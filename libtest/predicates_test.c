@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../lib/predicates.h"
+
+#define RUNS 1000000
+#define GRID 64
+
+__extension__ typedef __int128 int128;
+
+#define THEAD(desc) printf("\ttest: %-40s", desc)
+#define TFOOT(ok) printf("\t      => %s\n", (ok?"SUCCESS":"FAIL"))
+
+static int sign(double d) {
+    return (d > 0) - (d < 0);
+}
+
+// Random integer in [-2^52, 2^52], exactly representable as a double
+static long long randomCoord(void) {
+    long long r = ((long long)rand() << 31) ^ rand();
+    return (r & ((1LL << 53) - 1)) - (1LL << 52);
+}
+
+/**
+ * Nearly collinear triples with large integer coordinates, compared against
+ * the exact determinant in 128 bit integer arithmetic.
+ */
+int test_nearlyCollinear(void) {
+    THEAD("orient2d() on nearly collinear triples");
+    int ok = 1, wrongNaive = 0;
+    for (int i=0; i<RUNS && ok; i++) {
+        long long ax = randomCoord() / 2, ay = randomCoord() / 2,
+                  dx = randomCoord() / 4, dy = randomCoord() / 4,
+                  t = rand() % 5 - 2;
+        long long bx = ax + dx, by = ay + dy,
+                  cx = ax + t*dx + rand() % 3 - 1, cy = ay + t*dy + rand() % 3 - 1;
+        int128 exact = (int128)(bx-ax)*(cy-ay) - (int128)(by-ay)*(cx-ax);
+        double a[2] = {ax, ay}, b[2] = {bx, by}, c[2] = {cx, cy};
+        double naive = (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0]);
+        ok &= (sign(orient2d(a, b, c)) == (exact > 0) - (exact < 0));
+        wrongNaive += (sign(naive) != (exact > 0) - (exact < 0));
+    }
+    TFOOT(ok);
+    printf("\t      (plain double arithmetic got %d of %d signs wrong)\n", wrongNaive, RUNS);
+    return ok;
+}
+
+/**
+ * Points on a tiny grid around (0.5, 0.5), against the line y = x through
+ * (12, 12) and (24, 24): the exact sign is that of y - x.
+ * (Kettner et al., "Classroom examples of robustness problems")
+ */
+int test_grid(void) {
+    THEAD("orient2d() on an ulp grid near y = x");
+    int ok = 1;
+    double b[2] = {12, 12}, c[2] = {24, 24};
+    for (int i=0; i<GRID; i++) {
+        for (int j=0; j<GRID; j++) {
+            double a[2] = {0.5 + i*DBL_EPSILON/2, 0.5 + j*DBL_EPSILON/2};
+            // a, b, c counter-clockwise iff a is above the line
+            ok &= (sign(orient2d(a, b, c)) == sign(a[1] - a[0]));
+        }
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int tests = 0, succeses = 0;
+    printf("===============================\n");
+    printf("Testing:\n");
+    tests++; succeses += test_nearlyCollinear();
+    tests++; succeses += test_grid();
+    printf("===============================\n");
+    printf("Performed %3d tests:\n", tests);
+    printf("\t  %3d failures\n", tests-succeses);
+    printf("\t  %3d succeses\n", succeses);
+    return (tests != succeses);
+}
@@ -16,7 +16,7 @@
 
 #define NUM_TESTS_VERBOSE 1
 #define NUM_TESTS_RUNTIME 1
-#define NUM_TESTS_NORMAL 8
+#define NUM_TESTS_NORMAL 9
 #define NODES_DEFAULT 25
 #define RUNSMAX 100
 
@@ -281,6 +281,72 @@ int test_linkedList(RBLTree *tree, int *keys, int n) {
     return ok;
 }
 
+// Orders leaves by the int they point to, times the sign in T->ctx
+static int compareData(RBLTree *T, const void *a, const void *b) {
+    int sign = *(int*)T->ctx,
+        u = sign * *(const int*)a,
+        v = sign * *(const int*)b;
+    return (u > v) - (u < v);
+}
+
+/**
+ * Tests a tree ordered by a compare callback on the data instead of the keys
+ * (all 0): insertions, deletions of random leaves and RBLtreeLowerBound.
+ * Success: if it is an RBL tree after every operation, the leaves are sorted
+ * and the lower bounds are those of a linear scan
+ */
+int test_compare(int nodes) {
+    THEAD("Compare callback and lower bound");
+
+    int ok = 1, sign = -1;
+    int *values = calloc(nodes+1, sizeof(int));
+    RBLNode **leaves = calloc(nodes+1, sizeof(RBLNode*));
+    RBLTree *tree = RBLinit();
+    tree->compare = compareData;
+    tree->ctx = &sign;
+    for (int i=0; i<nodes; i++) {
+        values[i] = rand() % (nodes+1);
+        leaves[i] = RBLnewNode(0, &values[i]);
+        RBLinsert(tree, leaves[i]);
+        ok &= RBLisRBLTree(tree);
+    }
+    // Delete about half of the leaves
+    int m = 0;
+    for (int i=0; i<nodes; i++) {
+        if (rand() % 2) {
+            RBLdelete(tree, leaves[i]);
+            free(leaves[i]);
+            ok &= RBLisRBLTree(tree);
+        } else
+            leaves[m++] = leaves[i];
+    }
+    TERROR(ok, "Expected an RBL tree after every operation\n");
+    // Sorted (descending, by the sign)
+    RBLNode *x = RBLtreeMinimum(tree, tree->root);
+    for (int i=0; i<m; i++, x = x->next)
+        ok &= (i == 0 || *(int*)x->prev->data >= *(int*)x->data);
+    TERROR(ok, "Expected the leaves sorted by the compare callback\n");
+    for (int v=-1; v<=nodes+1; v++) {
+        RBLNode *expected = tree->nil;
+        for (x = RBLtreeMinimum(tree, tree->root); m > 0; x = x->next) {
+            if (*(int*)x->data <= v) {
+                expected = x;
+                break;
+            }
+            if (x == RBLtreeMaximum(tree, tree->root))
+                break;
+        }
+        ok &= (RBLtreeLowerBound(tree, &v) == expected);
+        TERRORARG(ok, "Wrong lower bound of %d\n", v);
+    }
+    RBLtreeDestroy(tree); // Not part of test
+    free(leaves);
+    free(values);
+
+    TFOOT(ok);
+    return ok;
+}
+
 /**
  * RUNTIME TESTING:
  *     - Meause time-diff for command K times with inputsize N, take average
@@ -429,6 +495,7 @@ int main(int argc, char **argv) {
             tests[(j++)%NUM_TESTS_NORMAL] += test_successor(tree, keys, M);
             tests[(j++)%NUM_TESTS_NORMAL] += test_predecessor(tree, keys, M);
             tests[(j++)%NUM_TESTS_NORMAL] += test_linkedList(tree, keys, M);
+            tests[(j++)%NUM_TESTS_NORMAL] += test_compare(M);
             setTime(t_end);
             t_run = getTimeDiff(t_end, t_start);
             printExecTime(t_run, t_prep);
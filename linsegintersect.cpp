@@ -1,4 +1,665 @@
 #include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <algorithm>
+#include <vector>
 #include "linsegintersect.h"
+#include "lib/rbltree.h"
+#include "lib/eventqueue.h"
 
-// ...
+/**
+ * Bentley-Ottmann sweep [BO79] for all intersections of n line segments in
+ * O((n+k) log n) time for k intersection points, as in [dBCvKO08, ch. 2]
+ * turned by 90 degrees: the sweep line is vertical and moves to the right,
+ * the events are points in lexicographic (x, y) order, and the status is an
+ * RBLTree of the segments crossing the sweep line from bottom to top. Its
+ * leaf list gives the neighbors of a segment in O(1).
+ *
+ * At an event point p the segments starting at p, U(p), come from the event
+ * queue (an EventQueue, which coalesces the events at p), and the segments
+ * through p in the status, those ending at p, L(p), and those containing
+ * it, C(p), are found next to each other from RBLtreeLowerBound(). Two or
+ * more of them all meet at p. L(p) and C(p) are deleted, and U(p) and C(p)
+ * are inserted in their order right of p (by slope, vertical segments
+ * last), which swaps the segments crossing at p. Only the segments that
+ * become neighbors are tested for an intersection right of p.
+ *
+ * All of it is exact: intersection points are rationals X/D, Y/D of 128 bit
+ * ints, compared by products of up to 256 bits, so any int coordinates work.
+ * Degenerate input is allowed: shared endpoints, vertical segments, many
+ * segments through one point, collinear overlaps (which meet at every event
+ * point of the overlap), and segments that are a single point (which never
+ * enter the status).
+ */
+
+typedef __int128 int128;
+typedef unsigned __int128 uint128;
+
+#define FITS62(v) ((v) > -((int128)1 << 62) && (v) < ((int128)1 << 62))
+
+// A point with rational coordinates X/D, Y/D and D > 0
+struct sweepPoint {
+    int128 X, Y, D;
+};
+
+// Status entries are segments, and sentinels below and above all of them;
+// a key is an event point, searched for among the segments
+enum sweepKind { SEGMENT, KEY, BOTTOM, TOP };
+
+// A segment from its lexicographically smaller end (ax, ay) to (bx, by)
+struct sweepSegment {
+    long long ax, ay, bx, by;
+    int index;     // into the input
+    sweepKind kind;
+    RBLNode *leaf; // in the status
+};
+
+static int sign(int128 v) {
+    return (v > 0) - (v < 0);
+}
+
+// The 256 bit product of a and b as (hi, lo)
+static void multiply(uint128 a, uint128 b, uint128 *hi, uint128 *lo) {
+    const uint128 M = UINT64_MAX;
+    uint128 p00 = (a & M) * (b & M), p01 = (a & M) * (b >> 64),
+            p10 = (a >> 64) * (b & M), p11 = (a >> 64) * (b >> 64),
+            mid = (p00 >> 64) + (p01 & M) + (p10 & M);
+    *lo = (p00 & M) | (mid << 64);
+    *hi = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+}
+
+// Sign of a*b - c*d
+static int compareProducts(int128 a, int128 b, int128 c, int128 d) {
+    if (FITS62(a) && FITS62(b) && FITS62(c) && FITS62(d))
+        return sign(a*b - c*d);
+    int s = sign(a) * sign(b), t = sign(c) * sign(d);
+    if (s != t || s == 0)
+        return (s > t) - (s < t);
+    uint128 hi1, lo1, hi2, lo2;
+    multiply(a < 0 ? -(uint128)a : a, b < 0 ? -(uint128)b : b, &hi1, &lo1);
+    multiply(c < 0 ? -(uint128)c : c, d < 0 ? -(uint128)d : d, &hi2, &lo2);
+    int m = (hi1 != hi2 ? (hi1 > hi2) - (hi1 < hi2) : (lo1 > lo2) - (lo1 < lo2));
+    return s * m;
+}
+
+// Lexicographic (x, y) order of points
+static int comparePoints(const sweepPoint &p, const sweepPoint &q) {
+    int c = compareProducts(p.X, q.D, q.X, p.D);
+    return (c != 0 ? c : compareProducts(p.Y, q.D, q.Y, p.D));
+}
+
+// Positive if p is left of (above) segment s, 0 if it is on its line
+static int orientation(const sweepSegment *s, const sweepPoint &p) {
+    return compareProducts(s->bx - s->ax, p.Y - s->ay * p.D,
+                           s->by - s->ay, p.X - s->ax * p.D);
+}
+
+// Positive if s is steeper than t (vertical is steepest)
+static int compareSlopes(const sweepSegment *s, const sweepSegment *t) {
+    return sign((int128)(s->by - s->ay) * (t->bx - t->ax) -
+                (int128)(t->by - t->ay) * (s->bx - s->ax));
+}
+
+static bool isPoint(const sweepSegment *s) {
+    return s->ax == s->bx && s->ay == s->by;
+}
+
+static bool endsAt(const sweepSegment *s, const sweepPoint &p) {
+    return s->bx * p.D == p.X && s->by * p.D == p.Y;
+}
+
+struct sweepEndpoint {
+    long long x, y;
+    sweepSegment *s; // starting here, or NULL
+    bool operator<(const sweepEndpoint &e) const {
+        return x < e.x || (x == e.x && y < e.y);
+    }
+};
+
+static int compareEvents(const void *a, const void *b) {
+    return comparePoints(*(const sweepPoint*)a, *(const sweepPoint*)b);
+}
+
+struct sweep {
+    sweepSegment *segments;
+    int n;             // of them, followed by the sentinels
+    long long x0, x1;  // the slab x0 <= x < x1 swept
+    sweepPoint p;      // the current event point
+    RBLTree *status;
+    EventQueue *queue; // of points, with the segment starting there or NULL
+    std::vector<int> meeting; // the segments through p (into segments)
+    void (*found)(sweep *W);  // called when two or more meet at p
+    void *context;
+    long points;
+    bool stop;         // set by found to end the sweep
+};
+
+#define SEGMENT_OF(x) ((sweepSegment*)(x)->data)
+
+/**
+ * Order of the status at the current event point p, just right of it. The
+ * first segment always passes through p (it is being inserted), or is a key
+ * for p, which goes before all segments through p. So it only takes the side
+ * of p of the second segment, then slopes and indices.
+ */
+static int compareStatus(RBLTree *T, const void *x, const void *y) {
+    const sweep *W = (const sweep*)T->ctx;
+    const sweepSegment *a = (const sweepSegment*)x, *b = (const sweepSegment*)y;
+    if (a->kind == BOTTOM || b->kind == TOP) return -1;
+    if (a->kind == TOP || b->kind == BOTTOM) return 1;
+    int o = orientation(b, W->p);
+    if (o != 0) return o;
+    if (a->kind == KEY) return -1;
+    int s = compareSlopes(a, b);
+    if (s != 0) return s;
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+// Queues the intersection of neighbors s and t if it is one point right of p
+// (collinear overlaps start at the left end of one of them, an event anyway).
+// Without a queue (the Shamos-Hoey sweep) any intersection stops the sweep.
+// Returns false if out of memory
+static bool checkNeighbors(sweep *W, const sweepSegment *s, const sweepSegment *t) {
+    if (s->kind != SEGMENT || t->kind != SEGMENT) return true;
+    int128 dxs = s->bx - s->ax, dys = s->by - s->ay,
+           dxt = t->bx - t->ax, dyt = t->by - t->ay,
+           ex = t->ax - s->ax, ey = t->ay - s->ay,
+           den = dxs*dyt - dys*dxt,
+           u = ex*dyt - ey*dxt, // the point is s at u/den and t at v/den
+           v = ex*dys - ey*dxs;
+    if (den == 0) return true;
+    if (den < 0) {
+        den = -den;
+        u = -u;
+        v = -v;
+    }
+    if (u < 0 || u > den || v < 0 || v > den) return true;
+    if (W->queue == NULL) {
+        W->stop = true;
+        return true;
+    }
+    sweepPoint q = { s->ax*den + u*dxs, s->ay*den + u*dys, den };
+    if (comparePoints(q, W->p) <= 0 || compareProducts(q.X, 1, W->x1, q.D) >= 0)
+        return true;
+    return EQinsert(W->queue, &q, NULL) == 0;
+}
+
+static bool isThrough(const sweep *W, RBLNode *x) {
+    return SEGMENT_OF(x)->kind == SEGMENT && orientation(SEGMENT_OF(x), W->p) == 0;
+}
+
+/**
+ * Handles event point W->p, given the segments starting there, which are
+ * also in W->meeting along with those that are a single point at p.
+ * @return false if out of memory
+ */
+static bool handleEvent(sweep *W, const std::vector<int> &upper) {
+    RBLTree *T = W->status;
+    sweepSegment key = {};
+    key.kind = KEY;
+    // L(p) and C(p) follow the lower bound of p
+    RBLNode *first = RBLtreeLowerBound(T, &key), *above = first;
+    size_t starting = W->meeting.size();
+    while (isThrough(W, above)) {
+        W->meeting.push_back(SEGMENT_OF(above) - W->segments);
+        above = above->next;
+    }
+    RBLNode *below = first->prev;
+    if (W->meeting.size() > 1) {
+        W->points++;
+        if (W->found) W->found(W);
+        if (W->stop) return true;
+    }
+
+    // Delete L(p) and C(p), then insert C(p) and U(p) in their order right of p
+    for (size_t i=starting; i<W->meeting.size(); i++)
+        RBLdelete(T, W->segments[W->meeting[i]].leaf);
+    int inserted = 0;
+    for (size_t i=starting; i<W->meeting.size(); i++) {
+        sweepSegment *s = &W->segments[W->meeting[i]];
+        if (endsAt(s, W->p)) {
+            free(s->leaf);
+            s->leaf = NULL;
+        } else {
+            RBLinsert(T, s->leaf);
+            inserted++;
+        }
+    }
+    for (size_t i=0; i<upper.size(); i++) {
+        sweepSegment *s = &W->segments[upper[i]];
+        if ((s->leaf = RBLnewNode(0, s)) == NULL)
+            return false;
+        RBLinsert(T, s->leaf);
+        inserted++;
+    }
+
+    if (inserted == 0)
+        return checkNeighbors(W, SEGMENT_OF(below), SEGMENT_OF(above));
+    RBLNode *lowest = RBLtreeLowerBound(T, &key), *highest = lowest;
+    while (isThrough(W, highest->next))
+        highest = highest->next;
+    return checkNeighbors(W, SEGMENT_OF(lowest->prev), SEGMENT_OF(lowest)) &&
+           checkNeighbors(W, SEGMENT_OF(highest), SEGMENT_OF(highest->next));
+}
+
+// Adds segment s, starting at p, to the segments of the event (a segment
+// clipped to the slab may also end there)
+static void addStarting(sweep *W, const sweepSegment *s, std::vector<int> &upper) {
+    if (endsAt(s, W->p))
+        W->meeting.push_back(s - W->segments);
+    else
+        upper.push_back(s - W->segments);
+}
+
+static bool inSlab(const lineSegment &s, long long x0, long long x1) {
+    return std::min(s.x1, s.x2) < x1 && std::max(s.x1, s.x2) >= x0;
+}
+
+/**
+ * Sets up the segments in slab x0 <= x < x1, oriented from their
+ * lexicographically smaller end, their endpoints in the slab in
+ * lexicographic order, and the status with its sentinels. The segments
+ * starting left of the slab enter it at x0, which is up to the caller.
+ * @return false if out of memory (with nothing left to free)
+ */
+static bool sweepInit(sweep *W, const lineSegment *S, int n, long long x0, long long x1,
+                      std::vector<sweepEndpoint> &ends) {
+    int m = 0;
+    for (int i=0; i<n; i++)
+        m += inSlab(S[i], x0, x1);
+    W->segments = (sweepSegment*)malloc((m+2) * sizeof(sweepSegment));
+    W->n = m;
+    W->x0 = x0;
+    W->x1 = x1;
+    W->status = RBLinit();
+    W->queue = NULL;
+    W->points = 0;
+    W->stop = false;
+    if (W->segments == NULL || W->status == NULL) {
+        free(W->segments);
+        if (W->status) RBLtreeDestroy(W->status);
+        return false;
+    }
+    for (int i=0, j=0; i<n; i++) {
+        if (!inSlab(S[i], x0, x1)) continue;
+        sweepSegment *s = &W->segments[j++];
+        bool swap = S[i].x2 < S[i].x1 || (S[i].x2 == S[i].x1 && S[i].y2 < S[i].y1);
+        s->ax = (swap ? S[i].x2 : S[i].x1);
+        s->ay = (swap ? S[i].y2 : S[i].y1);
+        s->bx = (swap ? S[i].x1 : S[i].x2);
+        s->by = (swap ? S[i].y1 : S[i].y2);
+        s->index = i;
+        s->kind = SEGMENT;
+        s->leaf = NULL;
+        sweepEndpoint left = { s->ax, s->ay, s }, right = { s->bx, s->by, NULL };
+        if (s->ax >= x0)
+            ends.push_back(left);
+        if (!isPoint(s) && s->bx < x1)
+            ends.push_back(right);
+    }
+    std::sort(ends.begin(), ends.end());
+
+    // The sentinels keep the leaf list from wrapping around
+    sweepSegment *bottom = &W->segments[m], *top = &W->segments[m+1];
+    bottom->kind = BOTTOM;
+    top->kind = TOP;
+    bottom->index = top->index = -1;
+    RBLTree *T = W->status;
+    T->compare = compareStatus;
+    T->ctx = W;
+    bool ok = (bottom->leaf = RBLnewNode(0, bottom)) != NULL;
+    if (ok) RBLinsert(T, bottom->leaf);
+    ok = ok && (top->leaf = RBLnewNode(0, top)) != NULL;
+    if (ok) RBLinsert(T, top->leaf);
+    if (!ok) {
+        RBLtreeDestroy(T);
+        free(W->segments);
+    }
+    return ok;
+}
+
+static void sweepDestroy(sweep *W) {
+    // Frees the leaves still in the status as well
+    RBLtreeDestroy(W->status);
+    if (W->queue) EQdestroy(W->queue);
+    free(W->segments);
+}
+
+/**
+ * The sweep of slab x0 <= x < x1, calling W->found at every point in it
+ * where segments meet. A segment starting left of the slab starts at its
+ * point on x = x0 instead (clipped to the slab), and only intersections in
+ * the slab are queued, so every point is found by one slab alone.
+ * @return Number of such points, or -1 if out of memory
+ */
+static long sweepSlab(sweep *W, const lineSegment *S, int n, long long x0, long long x1) {
+    std::vector<sweepEndpoint> ends;
+    if (!sweepInit(W, S, n, x0, x1, ends))
+        return -1;
+    W->queue = EQinit(sizeof(sweepPoint), compareEvents);
+    bool ok = W->queue != NULL;
+    for (int i=0; i<W->n && ok; i++) {
+        const sweepSegment *s = &W->segments[i];
+        if (s->ax >= x0) continue;
+        int128 D = s->bx - s->ax;
+        sweepPoint p = { x0 * D, s->ay * D + (x0 - s->ax) * (int128)(s->by - s->ay), D };
+        ok = EQinsert(W->queue, &p, (void*)s) == 0;
+    }
+    // In order, the insertions only touch the rightmost nodes of the queue
+    for (size_t i=0; i<ends.size() && ok; i++) {
+        sweepPoint p = { ends[i].x, ends[i].y, 1 };
+        ok = EQinsert(W->queue, &p, ends[i].s) == 0;
+    }
+    std::vector<sweepEndpoint>().swap(ends);
+
+    std::vector<int> upper;
+    while (ok && !W->stop && !EQisEmpty(W->queue)) {
+        size_t count;
+        void **starting = EQpop(W->queue, &W->p, &count);
+        if (starting == NULL) {
+            ok = false;
+            break;
+        }
+        upper.clear();
+        W->meeting.clear();
+        for (size_t i=0; i<count; i++)
+            if (starting[i] != NULL)
+                addStarting(W, (const sweepSegment*)starting[i], upper);
+        W->meeting.insert(W->meeting.end(), upper.begin(), upper.end());
+        ok = handleEvent(W, upper);
+    }
+    sweepDestroy(W);
+    return (ok ? W->points : -1);
+}
+
+// The sweep of all segments (their indices into S and into W->segments are
+// the same)
+static long sweepSegments(sweep *W, const lineSegment *S, int n) {
+    return sweepSlab(W, S, n, INT_MIN, (long long)INT_MAX + 1);
+}
+
+static void stopSweep(sweep *W) {
+    W->stop = true;
+}
+
+/**
+ * The Shamos-Hoey sweep [SH76]: as the sweep above until the first
+ * intersection, so the status holds disjoint segments and there are no
+ * intersection events. The endpoints are the events, straight from the
+ * sorted array, and any intersection of new neighbors (W->queue is NULL) or
+ * two segments meeting at an endpoint stops it.
+ * @return 1 if two segments meet, 0 if not, or -1 if out of memory
+ */
+static int sweepAny(sweep *W, const lineSegment *S, int n) {
+    std::vector<sweepEndpoint> ends;
+    if (!sweepInit(W, S, n, INT_MIN, (long long)INT_MAX + 1, ends))
+        return -1;
+    W->found = stopSweep;
+    std::vector<int> upper;
+    bool ok = true;
+    for (size_t i=0; i<ends.size() && ok && !W->stop; ) {
+        sweepPoint p = { ends[i].x, ends[i].y, 1 };
+        W->p = p;
+        upper.clear();
+        W->meeting.clear();
+        for (; i<ends.size() && ends[i].x == p.X && ends[i].y == p.Y; i++)
+            if (ends[i].s != NULL)
+                addStarting(W, ends[i].s, upper);
+        W->meeting.insert(W->meeting.end(), upper.begin(), upper.end());
+        ok = handleEvent(W, upper);
+    }
+    sweepDestroy(W);
+    return (ok ? W->stop : -1);
+}
+
+struct reportContext {
+    segmentIntersectionFn report;
+    void *context;
+};
+
+static void reportPoint(sweep *W) {
+    const reportContext *R = (const reportContext*)W->context;
+    struct segmentIntersection I;
+    I.x = (double)((long double)W->p.X / (long double)W->p.D);
+    I.y = (double)((long double)W->p.Y / (long double)W->p.D);
+    I.count = (int)W->meeting.size();
+    I.segments = &W->meeting[0]; // all segments are swept, so indices into S
+    R->report(R->context, &I);
+}
+
+/**
+ * Finds all points where two or more of the segments meet, in
+ * O((n+k) log n) time for k such points. Collinear segments that overlap
+ * meet at every endpoint of a segment in their overlap.
+ * @param  S       Line segments
+ * @param  n       Number of segments
+ * @param  report  Called for every point, in lexicographic (x, y) order (may
+ *                 be NULL to only count them)
+ * @param  context Passed to report
+ * @return         Number of points, or -1 if out of memory
+ */
+long segmentIntersections(const lineSegment *S, int n,
+                          segmentIntersectionFn report, void *context) {
+    sweep W;
+    reportContext R = { report, context };
+    W.found = (report ? reportPoint : NULL);
+    W.context = &R;
+    return sweepSegments(&W, S, n);
+}
+
+// Adds the pairs meeting at p, collinear ones only where their overlap starts
+static void collectPairs(sweep *W) {
+    std::vector<int> *pairs = (std::vector<int>*)W->context;
+    const std::vector<int> &M = W->meeting;
+    for (size_t i=0; i<M.size(); i++) {
+        const sweepSegment *s = &W->segments[M[i]];
+        for (size_t j=i+1; j<M.size(); j++) {
+            const sweepSegment *t = &W->segments[M[j]];
+            if (compareSlopes(s, t) == 0) {
+                bool later = s->ax > t->ax || (s->ax == t->ax && s->ay > t->ay);
+                sweepPoint start = { later ? s->ax : t->ax, later ? s->ay : t->ay, 1 };
+                if (comparePoints(start, W->p) != 0)
+                    continue;
+            }
+            pairs->push_back(std::min(s->index, t->index));
+            pairs->push_back(std::max(s->index, t->index));
+        }
+    }
+}
+
+/**
+ * Finds every pair of intersecting segments (once, even if they overlap).
+ * @param  S     Line segments
+ * @param  n     Number of segments
+ * @param  pairs Receives the pairs of indices into S, two after the other
+ *               with the smaller first, grouped by the point where they meet
+ *               in lexicographic order; free() it
+ * @return       Number of pairs, or -1 if out of memory
+ */
+long segmentIntersectionPairs(const lineSegment *S, int n, int **pairs) {
+    std::vector<int> found;
+    sweep W;
+    W.found = collectPairs;
+    W.context = &found;
+    *pairs = NULL;
+    if (sweepSegments(&W, S, n) < 0)
+        return -1;
+    *pairs = (int*)malloc((found.size() + 1) * sizeof(int));
+    if (*pairs == NULL)
+        return -1;
+    for (size_t i=0; i<found.size(); i++)
+        (*pairs)[i] = found[i];
+    return (long)found.size() / 2;
+}
+
+/*
+ * Parallel mode:
+ * The plane is split into vertical slabs x0 <= x < x1 with about as many
+ * endpoints each (from a sample of them), and each slab is swept by a thread
+ * of its own. A segment crossing into a slab from the left is clipped to it:
+ * it starts at its (rational) point on x = x0. Points where segments meet
+ * are only found by the slab they are in, and a pair is reported at one
+ * point only (the start of the overlap of collinear ones), so no pair is
+ * reported by two slabs. Segments spanning many slabs are swept by each.
+ */
+#define PARALLEL_MIN_SEGMENTS 1024  // segments per thread worth a thread
+#define PARALLEL_MAX_THREADS 256
+#define PARALLEL_SAMPLES 64         // endpoints per slab for choosing bounds
+
+struct slabJob {
+    const lineSegment *S;
+    int n;
+    long long x0, x1;
+    std::vector<int> pairs;
+    bool ok;
+};
+
+static void *slabWorker(void *arg) {
+    slabJob *job = (slabJob*)arg;
+    sweep W;
+    W.found = collectPairs;
+    W.context = &job->pairs;
+    job->ok = sweepSlab(&W, job->S, job->n, job->x0, job->x1) >= 0;
+    return NULL;
+}
+
+// Runs slabWorker on each of the jobs, one thread per job (the first on this
+// thread)
+static void runWorkers(slabJob *jobs, int threads) {
+    pthread_t tids[PARALLEL_MAX_THREADS];
+    bool started[PARALLEL_MAX_THREADS];
+    for (int t=1; t<threads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, slabWorker, &jobs[t]) == 0);
+        if (!started[t])
+            slabWorker(&jobs[t]);
+    }
+    slabWorker(&jobs[0]);
+    for (int t=1; t<threads; t++)
+        if (started[t])
+            pthread_join(tids[t], NULL);
+}
+
+/**
+ * Finds every pair of intersecting segments using several threads.
+ * Same result as segmentIntersectionPairs(), but for the order of the pairs
+ * meeting at the same point.
+ * @param  S       Line segments
+ * @param  n       Number of segments
+ * @param  pairs   Receives the pairs as segmentIntersectionPairs() does
+ * @param  threads Number of threads (and slabs) to use
+ * @return         Number of pairs, or -1 if out of memory
+ */
+long segmentIntersectionPairsParallel(const lineSegment *S, int n, int **pairs, int threads) {
+    threads = std::min(threads, std::min(n / PARALLEL_MIN_SEGMENTS, PARALLEL_MAX_THREADS));
+    if (threads <= 1)
+        return segmentIntersectionPairs(S, n, pairs);
+
+    // Bounds of the slabs from an evenly spaced sample of the endpoints
+    int samples = PARALLEL_SAMPLES*threads;
+    std::vector<long long> sample(samples), bounds(1, INT_MIN);
+    for (int k=0; k<samples; k++) {
+        long long e = 2LL*n * k / samples;
+        sample[k] = (e % 2 ? S[e/2].x2 : S[e/2].x1);
+    }
+    std::sort(sample.begin(), sample.end());
+    for (int t=1; t<threads; t++)
+        if (sample[t*PARALLEL_SAMPLES] > bounds.back())
+            bounds.push_back(sample[t*PARALLEL_SAMPLES]);
+    bounds.push_back((long long)INT_MAX + 1);
+    threads = (int)bounds.size() - 1;
+
+    std::vector<slabJob> jobs(threads);
+    for (int t=0; t<threads; t++) {
+        jobs[t].S = S;
+        jobs[t].n = n;
+        jobs[t].x0 = bounds[t];
+        jobs[t].x1 = bounds[t+1];
+    }
+    runWorkers(&jobs[0], threads);
+
+    // The slabs are in x order, so are their points
+    size_t size = 0;
+    *pairs = NULL;
+    for (int t=0; t<threads; t++) {
+        if (!jobs[t].ok) return -1;
+        size += jobs[t].pairs.size();
+    }
+    *pairs = (int*)malloc((size + 1) * sizeof(int));
+    if (*pairs == NULL)
+        return -1;
+    size_t k = 0;
+    for (int t=0; t<threads; t++)
+        for (size_t i=0; i<jobs[t].pairs.size(); i++)
+            (*pairs)[k++] = jobs[t].pairs[i];
+    return (long)size / 2;
+}
+
+static bool lessSteep(const sweepSegment *s, const sweepSegment *t) {
+    return compareSlopes(s, t) < 0;
+}
+
+// Counts the pairs meeting at p as collectPairs() does: all of them, but
+// for collinear ones that both start before p (their overlap started there)
+static void countPairs(sweep *W) {
+    long *count = (long*)W->context;
+    long m = (long)W->meeting.size();
+    *count += m*(m-1) / 2;
+    std::vector<const sweepSegment*> before;
+    for (long i=0; i<m; i++) {
+        const sweepSegment *s = &W->segments[W->meeting[i]];
+        if (s->ax * W->p.D != W->p.X || s->ay * W->p.D != W->p.Y)
+            before.push_back(s);
+    }
+    // Segments through p of the same slope are collinear
+    std::sort(before.begin(), before.end(), lessSteep);
+    for (size_t i=0, j; i<before.size(); i=j) {
+        for (j=i+1; j<before.size() && compareSlopes(before[i], before[j]) == 0; j++);
+        *count -= (long)((j-i) * (j-i-1) / 2);
+    }
+}
+
+/**
+ * Counts the pairs of intersecting segments, as segmentIntersectionPairs()
+ * does but without storing them. (segmentIntersections() with a NULL report
+ * counts the points.)
+ * @param  S Line segments
+ * @param  n Number of segments
+ * @return   Number of pairs, or -1 if out of memory
+ */
+long segmentIntersectionCount(const lineSegment *S, int n) {
+    long count = 0;
+    sweep W;
+    W.found = countPairs;
+    W.context = &count;
+    return (sweepSegments(&W, S, n) < 0 ? -1 : count);
+}
+
+/**
+ * Tells if any two of the segments intersect, in O(n log n) time with the
+ * Shamos-Hoey sweep, which stops at the first intersection it finds.
+ * @param  S Line segments
+ * @param  n Number of segments
+ * @return   1 if two segments intersect, 0 if none do, or -1 if out of memory
+ */
+int segmentIntersectionAny(const lineSegment *S, int n) {
+    sweep W;
+    return sweepAny(&W, S, n);
+}
+
+
+/**
+ * [BO79]
+ *     Jon Bentley and Thomas Ottmann, "Algorithms for reporting and counting
+ *     geometric intersections", IEEE Transactions on Computers C-28 (1979)
+ *
+ * [dBCvKO08]
+ *     Mark de Berg, Otfried Cheong, Marc van Kreveld and Mark Overmars,
+ *     "Computational Geometry: Algorithms and Applications", 3rd edition,
+ *     Springer (2008)
+ *
+ * [SH76]
+ *     Michael Ian Shamos and Dan Hoey, "Geometric intersection problems",
+ *     17th Annual Symposium on Foundations of Computer Science (1976)
+ */
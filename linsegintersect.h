@@ -1,6 +1,36 @@
 #ifndef __LINSEGINTERSECT_H
 #define __LINSEGINTERSECT_H
 
-// ...
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-#endif /* __LINSEGINTERSECT_H */
\ No newline at end of file
+// A line segment between two points with int coordinates (of any order; a
+// segment may also be a single point)
+typedef struct lineSegment {
+    int x1, y1;
+    int x2, y2;
+} lineSegment;
+
+// A point where two or more segments meet
+struct segmentIntersection {
+    double x, y;         // the point (rounded, it is exact in the sweep)
+    int count;           // number of segments through it
+    const int *segments; // their indices, in no particular order
+};
+
+// Receives the intersection points in lexicographic (x, y) order
+typedef void (*segmentIntersectionFn)(void *context, const struct segmentIntersection *I);
+
+long segmentIntersections(const lineSegment *S, int n,
+                          segmentIntersectionFn report, void *context);
+long segmentIntersectionPairs(const lineSegment *S, int n, int **pairs);
+long segmentIntersectionPairsParallel(const lineSegment *S, int n, int **pairs, int threads);
+long segmentIntersectionCount(const lineSegment *S, int n);
+int segmentIntersectionAny(const lineSegment *S, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LINSEGINTERSECT_H */
@@ -0,0 +1,113 @@
+#include "onlinehull.h"
+#include "hullpart.h"
+
+/**
+ * Online convex hull: points are inserted one at a time in any order, and the
+ * hull is readable at any moment. Each part of the hull is a red-black tree
+ * keyed by x whose nodes hold the vertices (in x order) of that part.
+ * An insertion into a part is insertPart() of hullpart.c. Every point is
+ * popped at most once, so n insertions take O(n log n) time in total.
+ */
+
+// Vertices are nodes with their point, both on the heap
+static RBNode *newVertex(void *context, const point *p) {
+    point *q = malloc(sizeof(point));
+    if (q == NULL) return NULL;
+    *q = *p;
+    RBNode *z = RBnewNode(p->x, q);
+    if (z == NULL) free(q);
+    return z;
+}
+
+static void freeVertex(void *context, RBNode *x) {
+    free(x->data);
+    free(x);
+}
+
+static const struct partNodes heapNodes = { newVertex, freeVertex, NULL };
+
+static void freeSubtree(RBTree *T, RBNode *x) {
+    if (RBisLeaf(T, x)) return;
+    freeSubtree(T, x->left);
+    freeSubtree(T, x->right);
+    free(x->data);
+    free(x);
+}
+
+static void freeTree(RBTree *T) {
+    if (T == NULL) return;
+    freeSubtree(T, T->root);
+    free(T->nil);
+    free(T);
+}
+
+/**
+ * Creates an empty online hull.
+ * @return The hull, to be released with onlineHullFree(), or NULL
+ */
+onlineHull *onlineHullInit(void) {
+    onlineHull *H = malloc(sizeof(onlineHull));
+    if (H == NULL) return NULL;
+    H->upper = RBinit();
+    H->lower = RBinit();
+    if (H->upper == NULL || H->lower == NULL) {
+        onlineHullFree(H);
+        return NULL;
+    }
+    return H;
+}
+
+/**
+ * Adds a point to the hull in O(log n) amortized time.
+ * @param  H The hull
+ * @param  p The new point
+ * @return   true if p is a vertex of the hull after the insertion
+ */
+int onlineHullInsert(onlineHull *H, point p) {
+    int upper = insertPart(H->upper, UPPER, &p, &heapNodes, NULL, NULL) != NULL,
+        lower = insertPart(H->lower, LOWER, &p, &heapNodes, NULL, NULL) != NULL;
+    return upper || lower;
+}
+
+/**
+ * Reads the current hull in O(h) time (plus O(log n) to find its ends),
+ * in the same order as convexHullIndices(): clockwise from the
+ * lexicographically smallest point.
+ * @param  H   The hull
+ * @param  out Receives the vertices of the hull, or NULL to only count them;
+ *             room for onlineHullSize(H) points
+ * @return     Number of vertices of the hull
+ */
+int onlineHullVertices(onlineHull *H, point *out) {
+    RBTree *U = H->upper, *L = H->lower;
+    if (RBisEmpty(U)) return 0;
+    RBNode *first = RBtreeMinimum(U, U->root),
+           *last = RBtreeMaximum(U, U->root);
+    const point *start = partPoint(first), *end = partPoint(last);
+    int h = 0;
+    for (RBNode *x = first; !RBisLeaf(U, x); x = RBtreeSuccessor(U, x), h++)
+        if (out) out[h] = *partPoint(x);
+    // The lower part, but for the ends it shares with the upper part
+    for (RBNode *x = RBtreeMaximum(L, L->root); !RBisLeaf(L, x); x = RBtreePredecessor(L, x)) {
+        const point *q = partPoint(x);
+        if ((q->x == end->x && q->y == end->y) || (q->x == start->x && q->y == start->y))
+            continue;
+        if (out) out[h] = *q;
+        h++;
+    }
+    return h;
+}
+
+/**
+ * @return Number of vertices of the hull
+ */
+int onlineHullSize(onlineHull *H) {
+    return onlineHullVertices(H, NULL);
+}
+
+void onlineHullFree(onlineHull *H) {
+    if (H == NULL) return;
+    freeTree(H->upper);
+    freeTree(H->lower);
+    free(H);
+}
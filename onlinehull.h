@@ -0,0 +1,31 @@
+#ifndef __onlinehull_h
+#define __onlinehull_h
+
+#include "convexhull.h"
+#include "lib/rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Convex hull of a stream of points, maintained under insertions.
+ * The upper and lower part (as in convexHullSorted()) are kept in a red-black
+ * tree each, keyed by x, holding only the current hull vertices.
+ */
+typedef struct onlineHull {
+    RBTree *upper; // smallest y for each x
+    RBTree *lower; // largest y for each x
+} onlineHull;
+
+onlineHull *onlineHullInit(void);
+int onlineHullInsert(onlineHull *H, point p);
+int onlineHullSize(onlineHull *H);
+int onlineHullVertices(onlineHull *H, point *out);
+void onlineHullFree(onlineHull *H);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __onlinehull_h */
@@ -0,0 +1,251 @@
+#ifndef __pointfile_hpp
+#define __pointfile_hpp
+
+/**
+ * Binary point files, read by memory mapping them (POSIX).
+ * A point file is a 32 byte header followed by the points, as pairs of x
+ * and y in native byte order:
+ *   char     magic[8]   "CHPOINTS"
+ *   uint32_t version    1
+ *   uint32_t type       1: int32, 2: float, 3: double (see CoordType)
+ *   uint64_t count      number of points
+ *   uint64_t offset     of the first point from the start of the file
+ * An index file holds the indices of hull vertices (in clockwise order), as
+ * 4 byte indices if the points fit, else 8 byte ones:
+ *   char     magic[8]   "CHINDEX\0"
+ *   uint32_t version    1
+ *   uint32_t width      4 or 8
+ *   uint64_t count      number of indices
+ *   uint64_t points     number of points of the point file
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "convexhull.hpp"
+
+namespace compgeo {
+
+enum class CoordType : std::uint32_t {
+    Int32 = 1,
+    Float = 2,
+    Double = 3,
+};
+
+struct PointFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t type;
+    std::uint64_t count;
+    std::uint64_t offset;
+};
+static_assert(sizeof(PointFileHeader) == 32, "point file header is 32 bytes");
+
+struct IndexFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint64_t count;
+    std::uint64_t points;
+};
+static_assert(sizeof(IndexFileHeader) == 32, "index file header is 32 bytes");
+
+inline std::size_t coordSize(CoordType type) {
+    switch (type) {
+        case CoordType::Int32: return sizeof(std::int32_t);
+        case CoordType::Float: return sizeof(float);
+        case CoordType::Double: return sizeof(double);
+    }
+    return 0;
+}
+
+/**
+ * A point file mapped read-only into memory. The points are used where they
+ * are: points<T>() is the mapped array, nothing is parsed or copied.
+ */
+class MappedPoints {
+public:
+    MappedPoints() = default;
+    MappedPoints(const MappedPoints &) = delete;
+    MappedPoints &operator=(const MappedPoints &) = delete;
+    ~MappedPoints() { close(); }
+
+    /**
+     * Maps a point file and checks its header.
+     * @return false on error, see error()
+     */
+    bool open(const char *path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return fail(std::strerror(errno));
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return fail(std::strerror(errno));
+        }
+        length = std::size_t(st.st_size);
+        if (length < sizeof(PointFileHeader)) {
+            ::close(fd);
+            return fail("not a point file");
+        }
+        void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping stays valid
+        if (base == MAP_FAILED) return fail(std::strerror(errno));
+        data = static_cast<const char *>(base);
+        std::memcpy(&header, data, sizeof(header));
+
+        std::size_t size = coordSize(CoordType(header.type));
+        if (std::memcmp(header.magic, "CHPOINTS", 8) != 0 || header.version != 1 || size == 0)
+            return fail("not a point file (or unknown version or type)");
+        if (header.offset % size != 0 || header.offset > length
+                || header.count > (length - header.offset) / (2*size))
+            return fail("truncated point file");
+        return true;
+    }
+
+    void close() {
+        if (data != nullptr)
+            munmap(const_cast<char *>(data), length);
+        data = nullptr;
+        length = 0;
+    }
+
+    CoordType type() const { return CoordType(header.type); }
+    std::uint64_t size() const { return header.count; }
+
+    template <class T>
+    const Point2<T> *points() const {
+        return reinterpret_cast<const Point2<T> *>(data + header.offset);
+    }
+
+    // Tells the kernel how the points are read next: sequential access gets
+    // aggressive read-ahead (and pages freed behind), random access none
+    void adviseSequential() const { advise(MADV_SEQUENTIAL); }
+    void adviseRandom() const { advise(MADV_RANDOM); }
+
+    const char *error() const { return message; }
+
+private:
+    const char *data = nullptr;
+    std::size_t length = 0;
+    PointFileHeader header = {};
+    const char *message = "";
+
+    bool fail(const char *why) {
+        close();
+        message = why;
+        return false;
+    }
+    void advise(int advice) const {
+        if (data != nullptr)
+            madvise(const_cast<char *>(data), length, advice);
+    }
+};
+
+// Writes all of buffer to fd
+inline bool writeAll(int fd, const void *buffer, std::size_t size) {
+    const char *p = static_cast<const char *>(buffer);
+    while (size > 0) {
+        ssize_t k = ::write(fd, p, size);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        size -= std::size_t(k);
+    }
+    return true;
+}
+
+// Reads all of size bytes from fd into buffer
+inline bool readAll(int fd, void *buffer, std::size_t size) {
+    char *p = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t k = ::read(fd, p, size);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        size -= std::size_t(k);
+    }
+    return true;
+}
+
+/**
+ * Writes a point file.
+ * @param  pts   count points of type, as pairs of x and y
+ * @return       false on error (see errno)
+ */
+inline bool writePointFile(const char *path, CoordType type, const void *pts, std::uint64_t count) {
+    PointFileHeader header = { { 'C', 'H', 'P', 'O', 'I', 'N', 'T', 'S' }, 1,
+                               std::uint32_t(type), count, sizeof(PointFileHeader) };
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, &header, sizeof(header))
+           && writeAll(fd, pts, count * 2*coordSize(type));
+    return (::close(fd) == 0) && ok;
+}
+
+/**
+ * Writes an index file with the narrowest indices that fit.
+ * @param  hull   Indices of the hull vertices
+ * @param  points Number of points they index
+ * @return        false on error (see errno)
+ */
+template <class Index>
+bool writeIndexFile(const char *path, const std::vector<Index> &hull, std::uint64_t points) {
+    std::uint32_t width = (points <= UINT32_MAX ? 4 : 8);
+    IndexFileHeader header = { { 'C', 'H', 'I', 'N', 'D', 'E', 'X', '\0' }, 1, width,
+                               hull.size(), points };
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, &header, sizeof(header));
+    if (width == 4) {
+        std::vector<std::uint32_t> narrow(hull.begin(), hull.end());
+        ok = ok && writeAll(fd, narrow.data(), narrow.size()*sizeof(std::uint32_t));
+    } else {
+        std::vector<std::uint64_t> wide(hull.begin(), hull.end());
+        ok = ok && writeAll(fd, wide.data(), wide.size()*sizeof(std::uint64_t));
+    }
+    return (::close(fd) == 0) && ok;
+}
+
+/**
+ * Reads an index file.
+ * @return false on error
+ */
+inline bool readIndexFile(const char *path, std::vector<std::uint64_t> &hull, std::uint64_t *points = nullptr) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    IndexFileHeader header;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && std::uint64_t(st.st_size) >= sizeof(header)
+           && readAll(fd, &header, sizeof(header))
+           && std::memcmp(header.magic, "CHINDEX", 8) == 0 && header.version == 1
+           && (header.width == 4 || header.width == 8)
+           // The count is untrusted: the indices have to be in the file
+           && header.count <= (std::uint64_t(st.st_size) - sizeof(header)) / header.width;
+    if (ok) {
+        std::vector<char> raw(header.count * header.width);
+        ok = readAll(fd, raw.data(), raw.size());
+        hull.resize(header.count);
+        for (std::uint64_t i=0; ok && i<header.count; i++) {
+            if (header.width == 4) {
+                std::uint32_t k;
+                std::memcpy(&k, &raw[4*i], 4);
+                hull[i] = k;
+            } else {
+                std::memcpy(&hull[i], &raw[8*i], 8);
+            }
+        }
+        if (points) *points = header.points;
+    }
+    ::close(fd);
+    return ok;
+}
+
+} // namespace compgeo
+
+#endif /* __pointfile_hpp */
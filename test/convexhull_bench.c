@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200112L // clock_gettime, getopt
+#include <time.h>
+#include <unistd.h>
+#include "../convexhull.h"
+#include "../kernelhull.h"
+
+/**
+ * Headless benchmark of the convex hull modes on several distributions,
+ * timing the phases of each run (see CH_TIMING in convexhull.c).
+ * Sizes go from -n to -N in steps of 10, and results are written as CSV or
+ * JSON to stdout. A size that does not fit in memory is skipped.
+ * The chan and batch modes have no phases, only their total time is
+ * reported. The batch mode splits the points into sets of 5 to 200 points.
+ * The kernel mode is the approximate hull of kernelhull.c (within -e times
+ * the radius of the points), streamed in blocks of the whole array; its h
+ * is the number of vertices of the approximation.
+ */
+
+#define RADIUS 1000000
+#define CLUSTERS 16
+#define BOUNDING_RADIUS (1.5 * RADIUS) // of every distribution (but rare gauss outliers)
+#define KERNEL_STREAM_BLOCK 65536
+
+static void printUsage(void) {
+    fprintf(stderr,
+        "Usage: convexhull_bench [options]\n"
+        "\t-d LIST  distributions: disk,square,circle,gauss,cluster (default: all)\n"
+        "\t-m LIST  modes: seq,parallel,chan,batch,kernel (default: all)\n"
+        "\t-n N     smallest number of points (default: 1000)\n"
+        "\t-N N     largest number of points (default: 100000000)\n"
+        "\t-t T     threads of the parallel mode (default: 4)\n"
+        "\t-e EPS   error of the kernel mode, relative (default: 0.001)\n"
+        "\t-r R     repetitions, the fastest is reported (default: 1)\n"
+        "\t-s SEED  random seed (default: 1)\n"
+        "\t-f FMT   output format: csv or json (default: csv)\n");
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static double uniform(void) {
+    return (double)rand() / RAND_MAX;
+}
+
+// Standard normal distribution (Box-Muller)
+static double gauss(void) {
+    double u = uniform(), v = uniform();
+    return sqrt(-2 * log(u > 0 ? u : DBL_MIN)) * cos(2 * 3.14159265 * v);
+}
+
+static void randomSquarePoints(point *Points, int n) {
+    for (int i=0; i<n; i++) {
+        Points[i].x = RADIUS * (2*uniform() - 1);
+        Points[i].y = RADIUS * (2*uniform() - 1);
+    }
+}
+
+// Every point is on the hull (up to rounding to integers)
+static void randomCirclePoints(point *Points, int n) {
+    for (int i=0; i<n; i++) {
+        double t = 2 * 3.14159265 * uniform();
+        Points[i].x = RADIUS * cos(t);
+        Points[i].y = RADIUS * sin(t);
+    }
+}
+
+static void randomGaussPoints(point *Points, int n) {
+    for (int i=0; i<n; i++) {
+        Points[i].x = RADIUS/4 * gauss();
+        Points[i].y = RADIUS/4 * gauss();
+    }
+}
+
+static void randomClusterPoints(point *Points, int n) {
+    double cx[CLUSTERS], cy[CLUSTERS];
+    for (int c=0; c<CLUSTERS; c++) {
+        cx[c] = RADIUS * (2*uniform() - 1);
+        cy[c] = RADIUS * (2*uniform() - 1);
+    }
+    for (int i=0; i<n; i++) {
+        int c = rand() % CLUSTERS;
+        Points[i].x = cx[c] + RADIUS/50 * gauss();
+        Points[i].y = cy[c] + RADIUS/50 * gauss();
+    }
+}
+
+static const struct distribution {
+    const char *name;
+    void (*generate)(point *Points, int n);
+} distributions[] = {
+    { "disk", NULL }, // randomDiskPoints() of convexhull.c
+    { "square", randomSquarePoints },
+    { "circle", randomCirclePoints },
+    { "gauss", randomGaussPoints },
+    { "cluster", randomClusterPoints },
+};
+#define DISTRIBUTIONS (int)(sizeof(distributions) / sizeof(distributions[0]))
+
+enum mode { SEQ, PARALLEL, CHAN, BATCH, KERNEL, MODES };
+static const char *modeNames[MODES] = { "seq", "parallel", "chan", "batch", "kernel" };
+
+#define BATCH_MIN_SET 5
+#define BATCH_MAX_SET 200
+
+// Splits n points into sets for the batch mode
+static int batchSets(int *starts, int n) {
+    int sets = 0;
+    starts[0] = 0;
+    while (starts[sets] < n) {
+        int size = BATCH_MIN_SET + rand() % (BATCH_MAX_SET - BATCH_MIN_SET + 1);
+        starts[sets+1] = min(starts[sets] + size, n);
+        sets++;
+    }
+    return sets;
+}
+
+// Is name in the comma separated list (NULL is every name)?
+static int inList(const char *list, const char *name) {
+    if (list == NULL) return true;
+    size_t len = strlen(name);
+    for (const char *s = list; (s = strstr(s, name)) != NULL; s += len)
+        if ((s == list || s[-1] == ',') && (s[len] == ',' || s[len] == '\0'))
+            return true;
+    return false;
+}
+
+struct result {
+    int h;
+    double sort, chain, merge, total;
+};
+
+// Runs one mode on a copy of Points
+static struct result runMode(enum mode mode, const point *Points, point *Q, int *out,
+                             int n, int threads, const int *starts, int sets, double epsilon) {
+    struct result r = { 0, 0, 0, 0, 0 };
+    memcpy(Q, Points, n*sizeof(point));
+    memset(&convexHullTimings, 0, sizeof(convexHullTimings));
+    double t0 = seconds();
+    switch (mode) {
+        case SEQ:
+            convexHullFree(convexHull(Q, n));
+            r.total = seconds() - t0;
+            r.h = convexHullSorted(Q, n, out); // Q is sorted by now
+            break;
+        case PARALLEL:
+            r.h = convexHullParallel(Q, n, out, threads);
+            r.total = seconds() - t0;
+            break;
+        case CHAN:
+            r.h = convexHullChan(Q, n, out);
+            r.total = seconds() - t0;
+            break;
+        case KERNEL: {
+            kernelHull *K = kernelHullInit(0, 0, BOUNDING_RADIUS, epsilon);
+            if (K == NULL) break;
+            for (int start=0; start<n; start+=KERNEL_STREAM_BLOCK)
+                kernelHullAdd(K, &Points[start], min(KERNEL_STREAM_BLOCK, n - start));
+            r.h = kernelHullVertices(K, Q);
+            r.total = seconds() - t0;
+            kernelHullFree(K);
+            memset(&convexHullTimings, 0, sizeof(convexHullTimings));
+            break;
+        }
+        default: // the hull starts go after the room for the hulls
+            r.h = convexHullBatch(Q, starts, sets, out, out + n + sets, threads);
+            r.total = seconds() - t0;
+            break;
+    }
+    r.sort = convexHullTimings.sort;
+    r.chain = convexHullTimings.chain;
+    r.merge = convexHullTimings.merge;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    const char *dists = NULL, *modes = NULL;
+    long long minPoints = 1000, maxPoints = 100000000;
+    int threads = 4, reps = 1, json = false, opt;
+    double epsilon = 0.001;
+    unsigned seed = 1;
+    while ((opt = getopt(argc, argv, "d:m:n:N:t:e:r:s:f:h")) != -1) {
+        switch (opt) {
+            case 'd': dists = optarg; break;
+            case 'm': modes = optarg; break;
+            case 'n': minPoints = atof(optarg); break;
+            case 'N': maxPoints = atof(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'e': epsilon = atof(optarg); break;
+            case 'r': reps = max(1, atoi(optarg)); break;
+            case 's': seed = atoi(optarg); break;
+            case 'f': json = (strcmp(optarg, "json") == 0); break;
+            default:
+                printUsage();
+                return (opt != 'h');
+        }
+    }
+    maxPoints = min(maxPoints, INT32_MAX - 1);
+
+    if (json) printf("[");
+    else      printf("distribution,mode,threads,n,h,sort_s,chain_s,merge_s,total_s\n");
+    int first = true;
+    for (long long n=minPoints; n<=maxPoints; n*=10) {
+        point *P = malloc(n*sizeof(point)), *Q = malloc(n*sizeof(point));
+        int maxSets = n/BATCH_MIN_SET + 1,
+            *out = malloc((n + 2*maxSets + 1)*sizeof(int)),
+            *starts = malloc((maxSets + 1)*sizeof(int));
+        if (P == NULL || Q == NULL || out == NULL || starts == NULL) {
+            fprintf(stderr, "Skipping n = %lld: out of memory\n", n);
+            free(P);
+            free(Q);
+            free(out);
+            free(starts);
+            continue;
+        }
+        for (int d=0; d<DISTRIBUTIONS; d++) {
+            if (!inList(dists, distributions[d].name)) continue;
+            srand(seed);
+            if (distributions[d].generate == NULL)
+                randomDiskPoints(P, n, 0, 0, RADIUS);
+            else
+                distributions[d].generate(P, n);
+            int sets = batchSets(starts, n);
+            for (int m=0; m<MODES; m++) {
+                if (!inList(modes, modeNames[m])) continue;
+                struct result best = runMode(m, P, Q, out, n, threads, starts, sets, epsilon);
+                for (int r=1; r<reps; r++) {
+                    struct result res = runMode(m, P, Q, out, n, threads, starts, sets, epsilon);
+                    if (res.total < best.total) best = res;
+                }
+                int t = (m == PARALLEL || m == BATCH ? threads : 1);
+                if (json)
+                    printf("%s\n  {\"distribution\": \"%s\", \"mode\": \"%s\", "
+                           "\"threads\": %d, \"n\": %lld, \"h\": %d, \"sort_s\": %.6f, "
+                           "\"chain_s\": %.6f, \"merge_s\": %.6f, \"total_s\": %.6f}",
+                           (first ? "" : ","), distributions[d].name, modeNames[m],
+                           t, n, best.h, best.sort, best.chain, best.merge, best.total);
+                else
+                    printf("%s,%s,%d,%lld,%d,%.6f,%.6f,%.6f,%.6f\n",
+                           distributions[d].name, modeNames[m], t, n, best.h,
+                           best.sort, best.chain, best.merge, best.total);
+                fflush(stdout);
+                first = false;
+            }
+        }
+        free(P);
+        free(Q);
+        free(out);
+        free(starts);
+    }
+    if (json) printf("\n]\n");
+    return 0;
+}
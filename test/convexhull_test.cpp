@@ -0,0 +1,913 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../convexhull.h"
+#include "../convexhull.hpp"
+#include "../pointfile.hpp"
+#include "../convexhull3d.h"
+#include "../onlinehull.h"
+#include "../dynamichull.h"
+#include "../windowhull.h"
+#include "../hullquery.h"
+#include "../calipers.h"
+#include "../kernelhull.h"
+#include <set>
+#include <utility>
+#include <malloc.h>
+
+#define RUNS 200
+#define NUMBER_OF_POINTS 2000
+
+#define THEAD(desc) printf("\ttest: %-40s", desc)
+#define TFOOT(ok) printf("\t      => %s\n", (ok?"SUCCESS":"FAIL"))
+
+using compgeo::Point2;
+
+// Random points in a disk (as convexhull.c) or a small square (many duplicates)
+static int randomPoints(point *P, int run) {
+    int n = 1 + rand() % NUMBER_OF_POINTS;
+    for (int i=0; i<n; i++) {
+        if (run % 2) {
+            double r = 10000 * sqrt((double)rand() / RAND_MAX),
+                   t = 2 * M_PI * ((double)rand() / RAND_MAX);
+            P[i].x = r * cos(t);
+            P[i].y = r * sin(t);
+        } else {
+            P[i].x = rand() % 8;
+            P[i].y = rand() % 8;
+        }
+    }
+    return n;
+}
+
+// Checks that hull is CH(P): strictly convex and no point outside of it
+static bool isConvexHull(const point *P, int n, const int *hull, int h) {
+    if (h < 3) return h >= 1 && h <= 2;
+    for (int i=0; i<h; i++) {
+        const point &a = P[hull[i]], &b = P[hull[(i+1)%h]], &c = P[hull[(i+2)%h]];
+        if (compgeo::orientation(a, b, c) <= 0)
+            return false;
+        for (int j=0; j<n; j++)
+            if (compgeo::orientation(a, b, P[j]) < 0)
+                return false;
+    }
+    return true;
+}
+
+static bool sameHull(const point *P, const int *hull, int h,
+                     const point *Q, const int *hull2, int h2) {
+    if (h != h2) return false;
+    for (int i=0; i<h; i++)
+        if (P[hull[i]].x != Q[hull2[i]].x || P[hull[i]].y != Q[hull2[i]].y)
+            return false;
+    return true;
+}
+
+int test_indices(void) {
+    THEAD("convexHullIndices() computes CH(P)");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        int h = convexHullIndices(P.data(), n, hull.data());
+        ok &= isConvexHull(P.data(), n, hull.data(), h);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_largeCoordinates(void) {
+    THEAD("convexHullIndices() on full int range");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        for (int i=0; i<n; i++) {
+            P[i].x = (int)(((unsigned)P[i].x << 18) ^ (unsigned)rand());
+            P[i].y = (int)(((unsigned)P[i].y << 18) ^ (unsigned)rand());
+        }
+        int h = convexHullIndices(P.data(), n, hull.data());
+        ok &= isConvexHull(P.data(), n, hull.data(), h);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_sortPoints(void) {
+    THEAD("sortPoints() agrees with lexicographic order");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), tmp(NUMBER_OF_POINTS);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        sortPoints(P.data(), n, tmp.data());
+        for (int i=1; i<n; i++)
+            ok &= !compgeo::lessXY(P[i], P[i-1]);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_prefilter(void) {
+    THEAD("Prefilter keeps every hull vertex");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), Q(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1), hull2(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        Q = P;
+        int h = convexHullIndices(P.data(), n, hull.data()),
+            m = convexHullPrefilter(Q.data(), n),
+            h2 = convexHullIndices(Q.data(), m, hull2.data());
+        ok &= sameHull(P.data(), hull.data(), h, Q.data(), hull2.data(), h2);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_parallel(void) {
+    THEAD("convexHullParallel() agrees with one thread");
+    bool ok = true;
+    int n = 200000;
+    std::vector<point> P(n), Q(n);
+    std::vector<int> hull(n+1), hull2(n+1);
+    for (int run=0; run<4 && ok; run++) {
+        for (int i=0; i<n; i++) {
+            P[i].x = rand() % (run < 2 ? 20000 : 3);
+            P[i].y = rand() % (run < 2 ? 20000 : 3);
+        }
+        Q = P;
+        int h = convexHullIndices(P.data(), n, hull.data()),
+            h2 = convexHullParallel(Q.data(), n, hull2.data(), 2+3*run);
+        ok &= sameHull(P.data(), hull.data(), h, Q.data(), hull2.data(), h2);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_chan(void) {
+    THEAD("convexHullChan() agrees with convexHullIndices()");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), Q(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1), hull2(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        Q = P;
+        int h = convexHullIndices(P.data(), n, hull.data()),
+            h2 = convexHullChan(Q.data(), n, hull2.data());
+        ok &= sameHull(P.data(), hull.data(), h, Q.data(), hull2.data(), h2);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_batch(void) {
+    THEAD("convexHullBatch() agrees with each set");
+    bool ok = true;
+    for (int run=0; run<4 && ok; run++) {
+        // Sets of 0 to 200 points, both tiny and sorted by qsort
+        int sets = 2000 + rand() % 2000;
+        std::vector<int> starts(sets+1);
+        for (int s=0; s<sets; s++)
+            starts[s+1] = starts[s] + (s % 50 ? rand() % 20 : rand() % 201);
+        int n = starts[sets];
+        std::vector<point> P(n);
+        for (int i=0; i<n; i++) {
+            P[i].x = rand() % (run % 2 ? 20000 : 8);
+            P[i].y = rand() % (run % 2 ? 20000 : 8);
+        }
+        std::vector<point> Q(P);
+        std::vector<int> out(n+sets), hullStarts(sets+1), hull(202);
+        int total = convexHullBatch(Q.data(), starts.data(), sets, out.data(),
+                                    hullStarts.data(), 1+run);
+        ok &= (total == hullStarts[sets]);
+        for (int s=0; s<sets && ok; s++) {
+            point *R = &P[starts[s]];
+            int h = convexHullIndices(R, starts[s+1]-starts[s], hull.data());
+            ok &= sameHull(R, hull.data(), h, &Q[starts[s]], &out[hullStarts[s]],
+                           hullStarts[s+1] - hullStarts[s]);
+        }
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// A context of one thread, counting its allocations and messages
+struct contextJob {
+    struct hullContext ctx;
+    int blocks, messages, seed;
+    bool ok;
+};
+static void *countingAlloc(void *user, size_t size) {
+    ((contextJob *)user)->blocks++;
+    return malloc(size);
+}
+static void countingRelease(void *user, void *block) {
+    ((contextJob *)user)->blocks -= (block != NULL);
+    free(block);
+}
+static void countingLog(void *user, const char *message) {
+    ((contextJob *)user)->messages += (message[0] != '\0');
+}
+static void *contextWorker(void *arg) {
+    contextJob *J = (contextJob *)arg;
+    std::vector<point> P(NUMBER_OF_POINTS), Q(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    unsigned seed = J->seed;
+    for (int run=0; run<RUNS && J->ok; run++) {
+        int n = 1 + rand_r(&seed) % NUMBER_OF_POINTS;
+        for (int i=0; i<n; i++) {
+            P[i].x = rand_r(&seed) % (run % 2 ? 20000 : 8);
+            P[i].y = rand_r(&seed) % (run % 2 ? 20000 : 8);
+        }
+        Q = P;
+        int h = convexHullIndices(Q.data(), n, hull.data()), k = 0;
+        struct circleq *chull = convexHullWith(&J->ctx, P.data(), n);
+        struct entry *e;
+        CIRCLEQ_FOREACH(e, chull, entries) {
+            J->ok &= (k < h && e->rect->x == Q[hull[k]].x && e->rect->y == Q[hull[k]].y);
+            k++;
+        }
+        J->ok &= (k == h);
+        convexHullFreeWith(&J->ctx, chull);
+    }
+    return NULL;
+}
+
+int test_context(void) {
+    THEAD("convexHullWith() on concurrent threads");
+    const int threads = 4;
+    contextJob jobs[threads];
+    pthread_t tids[threads];
+    for (int t=0; t<threads; t++) {
+        contextJob &J = jobs[t];
+        convexHullContextInit(&J.ctx);
+        J.ctx.alloc = countingAlloc;
+        J.ctx.release = countingRelease;
+        J.ctx.log = countingLog;
+        J.ctx.user = &J;
+        J.blocks = J.messages = 0;
+        J.seed = t+1;
+        J.ok = true;
+        pthread_create(&tids[t], NULL, contextWorker, &J);
+    }
+    bool ok = true;
+    for (int t=0; t<threads; t++) {
+        pthread_join(tids[t], NULL);
+        convexHullContextFree(&jobs[t].ctx);
+        // Two messages per call, and every block released
+        ok &= jobs[t].ok && jobs[t].messages == 2*RUNS && jobs[t].blocks == 0;
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Hands out the points of an array in pieces of random size
+struct arrayReader {
+    const point *P;
+    int n, next;
+};
+static int readArray(void *context, point *buffer, int max) {
+    arrayReader *R = (arrayReader *)context;
+    int m = std::min(std::min(max, R->n - R->next), 1 + rand() % 300);
+    std::copy(R->P + R->next, R->P + R->next + m, buffer);
+    R->next += m;
+    return m;
+}
+
+// Heap accounting for the memory budget of convexHullExternal(): glibc's
+// malloc is interposed, counting the bytes allocated while heapCounting
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+}
+static bool heapCounting;
+static long long heapLive, heapPeak;
+static void heapCount(void *p, int sign) {
+    if (!heapCounting || p == NULL) return;
+    heapLive += sign * (long long)malloc_usable_size(p);
+    heapPeak = std::max(heapPeak, heapLive);
+}
+extern "C" void *malloc(size_t size) noexcept {
+    void *p = __libc_malloc(size);
+    heapCount(p, 1);
+    return p;
+}
+extern "C" void *calloc(size_t n, size_t size) noexcept {
+    void *p = __libc_calloc(n, size);
+    heapCount(p, 1);
+    return p;
+}
+extern "C" void *realloc(void *p, size_t size) noexcept {
+    heapCount(p, -1);
+    void *q = __libc_realloc(p, size);
+    heapCount(q != NULL || size == 0 ? q : p, 1);
+    return q;
+}
+extern "C" void free(void *p) noexcept {
+    heapCount(p, -1);
+    __libc_free(p);
+}
+
+int test_external(void) {
+    THEAD("convexHullExternal() agrees with CH(P)");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), Q(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1), order(NUMBER_OF_POINTS);
+    for (int i=0; i<NUMBER_OF_POINTS; i++)
+        order[i] = i;
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run) * (run % 7 != 0);
+        arrayReader R = { P.data(), n, 0 };
+        point *H;
+        // Room for 200 to 500 points at a time
+        size_t budget = (200 + rand() % 300) * (sizeof(point) + sizeof(int));
+        heapLive = heapPeak = 0;
+        heapCounting = true;
+        int h = convexHullExternal(readArray, &R, budget, &H);
+        heapCounting = false;
+        // Within the budget, but for the rounding of two allocations
+        ok &= (heapPeak <= (long long)(budget + 64));
+        Q.assign(P.begin(), P.begin() + n);
+        int h2 = convexHullIndices(Q.data(), n, hull.data());
+        ok &= (R.next == n) && sameHull(H, order.data(), h, Q.data(), hull.data(), h2);
+        free(H);
+    }
+
+    // From a file, and with a budget too small for the hull
+    FILE *file = tmpfile();
+    int n = randomPoints(P.data(), 1);
+    for (int i=0; i<n; i++) {
+        int32_t xy[2] = { P[i].x, P[i].y };
+        ok &= (fwrite(xy, sizeof(xy), 1, file) == 1);
+    }
+    rewind(file);
+    point *H;
+    int h = convexHullExternal(convexHullReadInt32, file, 1 << 12, &H);
+    int h2 = convexHullIndices(P.data(), n, hull.data());
+    ok &= sameHull(H, order.data(), h, P.data(), hull.data(), h2);
+    free(H);
+    n = NUMBER_OF_POINTS;
+    for (int i=0; i<n; i++) {
+        P[i].x = (int)(1e6 * cos(i * 2*M_PI/n));
+        P[i].y = (int)(1e6 * sin(i * 2*M_PI/n));
+    }
+    arrayReader R = { P.data(), n, 0 };
+    ok &= (convexHullExternal(readArray, &R, 1 << 10, &H) == -1 && H == NULL);
+    // A hull that only just fits once the input has ended
+    n = 90;
+    for (int i=0; i<n; i++) {
+        P[i].x = (int)(1e6 * cos(i * 2*M_PI/n));
+        P[i].y = (int)(1e6 * sin(i * 2*M_PI/n));
+    }
+    R = { P.data(), n, 0 };
+    h = convexHullExternal(readArray, &R, 101 * (sizeof(point) + sizeof(int)), &H);
+    h2 = convexHullIndices(P.data(), n, hull.data());
+    ok &= (h == n) && sameHull(H, order.data(), h, P.data(), hull.data(), h2);
+    free(H);
+    fclose(file);
+    TFOOT(ok);
+    return ok;
+}
+
+// Brute force containment in a hull with ccw() > 0 (or < 0) along its edges
+static bool bruteContains(const point *P, const int *hull, int h, point q) {
+    if (h <= 2) {
+        const point &a = P[hull[0]], &b = P[hull[h-1]];
+        return ccw(&a, &b, &q) == 0 && q.x >= std::min(a.x, b.x) && q.x <= std::max(a.x, b.x)
+            && q.y >= std::min(a.y, b.y) && q.y <= std::max(a.y, b.y);
+    }
+    int sign = ccw(&P[hull[0]], &P[hull[1]], &P[hull[2]]);
+    for (int i=0; i<h; i++)
+        if (ccw(&P[hull[i]], &P[hull[(i+1)%h]], &q) == -sign)
+            return false;
+    return true;
+}
+
+int test_query(void) {
+    THEAD("hullQuery*() agree with brute force");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    const int queries = 500;
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run), scale = (run % 4 == 1 ? 1 << 17 : 1);
+        if (run % 10 == 3) n = 1 + rand() % 2;
+        for (int i=0; i<n; i++) {
+            P[i].x *= scale;
+            P[i].y *= scale;
+        }
+        int h = convexHullIndices(P.data(), n, hull.data());
+        hullQuery *Q = hullQueryInit(P.data(), hull.data(), h);
+        // Points near the hull, many on its edges and vertices
+        int range = (run % 2 ? 12000 * scale : 10);
+        std::vector<int> x(queries), y(queries), left(queries), right(queries);
+        std::vector<unsigned char> inside(queries);
+        for (int i=0; i<queries; i++) {
+            if (i % 4 == 0) {
+                x[i] = P[rand() % n].x;
+                y[i] = P[rand() % n].y;
+            } else {
+                x[i] = (int)((2*(double)rand()/RAND_MAX - 1) * range);
+                y[i] = (int)((2*(double)rand()/RAND_MAX - 1) * range);
+            }
+        }
+        hullQueryContainsBatch(Q, x.data(), y.data(), queries, inside.data());
+        hullQueryTangentsBatch(Q, x.data(), y.data(), queries, left.data(), right.data());
+        for (int i=0; i<queries && ok; i++) {
+            point q = {x[i], y[i]};
+            bool in = bruteContains(P.data(), hull.data(), h, q);
+            ok &= (inside[i] == in) && (hullQueryContains(Q, q) == in) && ((left[i] < 0) == in);
+            for (int j=0; j<h && !in; j++) {
+                ok &= ccw(&q, &P[left[i]], &P[hull[j]]) <= 0;
+                ok &= ccw(&q, &P[right[i]], &P[hull[j]]) >= 0;
+            }
+        }
+        // Extreme vertices in integer directions (exact dot products)
+        std::vector<double> dx(queries), dy(queries);
+        for (int i=0; i<queries; i++) {
+            dx[i] = rand() % 201 - 100;
+            dy[i] = rand() % 201 - 100;
+        }
+        hullQueryExtremeBatch(Q, dx.data(), dy.data(), queries, left.data());
+        for (int i=0; i<queries && ok; i++) {
+            int v = hullQueryExtreme(Q, dx[i], dy[i]);
+            ok &= (left[i] == v);
+            for (int j=0; j<h; j++)
+                ok &= dx[i]*P[v].x + dy[i]*P[v].y >= dx[i]*P[hull[j]].x + dy[i]*P[hull[j]].y;
+        }
+        hullQueryFree(Q);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Distance of P[hull[k]] from the line of edge i, times the length of the edge
+static __int128 edgeHeight(const point *P, const int *hull, int h, int i, int k) {
+    const point &a = P[hull[i]], &b = P[hull[(i+1)%h]], &c = P[hull[k]];
+    return (__int128)((long long)b.x - a.x) * ((long long)c.y - a.y)
+         - (__int128)((long long)b.y - a.y) * ((long long)c.x - a.x);
+}
+
+static bool near(double a, double b) {
+    return fabs(a - b) <= 1e-9 * std::max(1.0, std::max(fabs(a), fabs(b)));
+}
+
+int test_calipers(void) {
+    THEAD("hullCalipers() agrees with brute force");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1), pairs(3*NUMBER_OF_POINTS);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run), scale = (run % 4 == 1 ? 1 << 17 : 1);
+        for (int i=0; i<n; i++) {
+            P[i].x *= scale;
+            P[i].y *= scale;
+        }
+        int h = convexHullIndices(P.data(), n, hull.data());
+        struct hullMeasures m;
+        hullCalipers(P.data(), hull.data(), h, &m);
+        if (h < 3) {
+            ok &= (m.width == 0 && m.minArea.width * m.minArea.height == 0);
+            continue;
+        }
+        double diameter = 0, width = HUGE_VAL, area = HUGE_VAL, perimeter = HUGE_VAL;
+        std::set<std::pair<int, int>> antipodal;
+        for (int i=0; i<h; i++) {
+            const point &a = P[hull[i]], &b = P[hull[(i+1)%h]];
+            double ex = (double)b.x - a.x, ey = (double)b.y - a.y, len = sqrt(ex*ex + ey*ey),
+                   lo = HUGE_VAL, hi = -HUGE_VAL, height = 0;
+            __int128 farthest = 0;
+            for (int k=0; k<h; k++) {
+                const point &c = P[hull[k]];
+                double dx = (double)c.x - a.x, dy = (double)c.y - a.y;
+                diameter = std::max(diameter, sqrt(dx*dx + dy*dy));
+                lo = std::min(lo, (ex*dx + ey*dy) / len);
+                hi = std::max(hi, (ex*dx + ey*dy) / len);
+                height = std::max(height, (ex*dy - ey*dx) / len);
+                farthest = std::max(farthest, edgeHeight(P.data(), hull.data(), h, i, k));
+            }
+            for (int k=0; k<h; k++) {
+                if (edgeHeight(P.data(), hull.data(), h, i, k) != farthest) continue;
+                for (int v : { i, (i+1) % h })
+                    antipodal.insert(std::make_pair(std::min(v, k), std::max(v, k)));
+            }
+            width = std::min(width, height);
+            area = std::min(area, (hi - lo) * height);
+            perimeter = std::min(perimeter, 2 * (hi - lo + height));
+        }
+        ok &= near(m.diameter, diameter) && near(m.width, width)
+           && near(m.minArea.width * m.minArea.height, area)
+           && near(2 * (m.minPerimeter.width + m.minPerimeter.height), perimeter);
+        int count = hullAntipodalPairs(P.data(), hull.data(), h, pairs.data());
+        std::set<std::pair<int, int>> listed;
+        for (int k=0; k<count; k++)
+            listed.insert(std::make_pair(pairs[2*k], pairs[2*k+1]));
+        ok &= (count == (int)listed.size()) && (listed == antipodal) && (count <= 3*h/2);
+    }
+
+    // The batch agrees with single hulls, on enough sets for a few threads
+    int sets = 1000;
+    std::vector<point> Q(20*sets);
+    std::vector<int> starts(sets+1), out(Q.size()+sets), hullStarts(sets+1);
+    for (int s=0; s<sets; s++)
+        starts[s+1] = starts[s] + rand() % 20;
+    for (int i=0; i<starts[sets]; i++) {
+        Q[i].x = rand() % 1000;
+        Q[i].y = rand() % 1000;
+    }
+    convexHullBatch(Q.data(), starts.data(), sets, out.data(), hullStarts.data(), 4);
+    std::vector<struct hullMeasures> batch(sets);
+    hullCalipersBatch(Q.data(), starts.data(), out.data(), hullStarts.data(), sets, batch.data(), 4);
+    for (int s=0; s<sets; s++) {
+        struct hullMeasures m;
+        hullCalipers(&Q[starts[s]], &out[hullStarts[s]], hullStarts[s+1] - hullStarts[s], &m);
+        ok &= (m.diameter == batch[s].diameter && m.width == batch[s].width
+               && m.minArea.edge == batch[s].minArea.edge);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Distance of q from the polygon H of h vertices with ccw() > 0 along it
+static double polygonDistance(const point *H, int h, const point &q) {
+    bool inside = (h >= 3);
+    double best = HUGE_VAL;
+    for (int i=0; i<h; i++) {
+        const point &a = H[i], &b = H[(i+1) % h];
+        double ex = (double)b.x - a.x, ey = (double)b.y - a.y,
+               dx = (double)q.x - a.x, dy = (double)q.y - a.y,
+               len2 = ex*ex + ey*ey,
+               t = (len2 > 0 ? std::min(1.0, std::max(0.0, (ex*dx + ey*dy) / len2)) : 0);
+        best = std::min(best, hypot(dx - t*ex, dy - t*ey));
+        inside &= (ccw(&a, &b, &q) >= 0);
+    }
+    return (inside ? 0 : best);
+}
+
+int test_kernel(void) {
+    THEAD("kernelHull within its error of CH(P)");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), H;
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    const double epsilons[] = { 0.1, 0.01, 0.001 };
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run), scale = (run % 4 == 1 ? 1 << 12 : 1),
+            ox = rand() % 100000 - 50000, oy = rand() % 100000 - 50000;
+        double radius = (run % 2 ? 10000.0 * scale : 5), epsilon = epsilons[run % 3];
+        if (run % 5 == 3) {
+            // All points on the hull
+            for (int i=0; i<n; i++) {
+                P[i].x = (int)(10000 * cos(i * 2*M_PI/n));
+                P[i].y = (int)(10000 * sin(i * 2*M_PI/n));
+            }
+            radius = 10000;
+            scale = 1;
+        }
+        for (int i=0; i<n; i++) {
+            P[i].x = P[i].x * scale + ox;
+            P[i].y = P[i].y * scale + oy;
+        }
+        double cx = ox + (run % 2 || run % 5 == 3 ? 0 : 3.5), cy = oy + (cx == ox ? 0 : 3.5);
+        kernelHull *K = kernelHullInit(cx, cy, radius, epsilon);
+        for (int start=0; start<n; ) {
+            int m = std::min(n - start, 1 + rand() % 5000);
+            kernelHullAdd(K, &P[start], m);
+            start += m;
+        }
+        H.resize(K->sites);
+        int k = kernelHullVertices(K, H.data());
+        double error = kernelHullError(K);
+        ok &= (k >= 1 && k <= K->sites && error <= epsilon * radius * (1 + 1e-9));
+        ok &= (K->sites <= (int)ceil(M_PI * sqrt(2 / epsilon)) + 1);
+        // Vertices are points of P, and every point of P is close
+        std::set<std::pair<int, int>> points;
+        for (int i=0; i<n; i++)
+            points.insert(std::make_pair(P[i].x, P[i].y));
+        for (int i=0; i<k; i++)
+            ok &= (points.count(std::make_pair(H[i].x, H[i].y)) == 1);
+        int h = convexHullIndices(P.data(), n, hull.data());
+        for (int i=0; i<h; i++)
+            ok &= (polygonDistance(H.data(), k, P[hull[i]]) <= error * (1 + 1e-9) + 1e-6);
+        kernelHullFree(K);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_online(void) {
+    THEAD("onlineHullInsert() agrees with CH(P)");
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS), Q(NUMBER_OF_POINTS+1);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        onlineHull *H = onlineHullInit();
+        for (int i=0; i<n; i++) {
+            onlineHullInsert(H, P[i]);
+            // Check some of the intermediate hulls as well
+            if (i % 97 == 0 || i == n-1) {
+                std::vector<point> R(P.begin(), P.begin()+i+1);
+                int h = convexHullIndices(R.data(), i+1, hull.data()),
+                    h2 = onlineHullVertices(H, Q.data());
+                ok &= (h2 == onlineHullSize(H));
+                for (int j=0; ok && j<h; j++)
+                    ok &= (h == h2 && R[hull[j]].x == Q[j].x && R[hull[j]].y == Q[j].y);
+            }
+        }
+        onlineHullFree(H);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_dynamic(void) {
+    THEAD("dynamicHullDelete() agrees with CH(P)");
+    bool ok = true;
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS/10 && ok; run++) {
+        dynamicHull *H = dynamicHullInit();
+        std::vector<point> S;
+        for (int i=0; i<NUMBER_OF_POINTS/4 && ok; i++) {
+            // Insert two points for each deletion
+            if (S.empty() || rand() % 3) {
+                point p;
+                p.x = rand() % (run % 2 ? 20000 : 8);
+                p.y = rand() % (run % 2 ? 20000 : 8);
+                S.push_back(p);
+                ok &= dynamicHullInsert(H, p);
+            } else {
+                int j = rand() % S.size();
+                ok &= dynamicHullDelete(H, S[j]);
+                S.erase(S.begin() + j);
+            }
+            std::vector<point> R(S), Q(S.size()+1);
+            int h = convexHullIndices(R.data(), R.size(), hull.data()),
+                h2 = dynamicHullVertices(H, Q.data());
+            // convexHullIndices() reports equal points twice
+            if (h == 2 && R[hull[0]].x == R[hull[1]].x && R[hull[0]].y == R[hull[1]].y)
+                h = 1;
+            ok &= (h == h2);
+            for (int j=0; ok && j<h; j++)
+                ok &= (R[hull[j]].x == Q[j].x && R[hull[j]].y == Q[j].y);
+        }
+        dynamicHullFree(H);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int test_window(void) {
+    THEAD("windowHullPop() agrees with CH(P)");
+    bool ok = true;
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS/10 && ok; run++) {
+        windowHull *W = windowHullInit();
+        std::vector<point> S; // the window, oldest first
+        int window = 1 + rand() % 200;
+        for (int i=0; i<NUMBER_OF_POINTS/4 && ok; i++) {
+            // Random bursts of pushes and pops around the window size
+            if (S.empty() || (int)S.size() < window + rand() % 50 - 25) {
+                point p;
+                p.x = rand() % (run % 2 ? 20000 : 8);
+                p.y = rand() % (run % 2 ? 20000 : 8);
+                S.push_back(p);
+                ok &= windowHullPush(W, p, i);
+            } else {
+                ok &= windowHullPop(W);
+                S.erase(S.begin());
+            }
+            std::vector<point> R(S), Q(S.size()+1);
+            int h = convexHullIndices(R.data(), R.size(), hull.data()),
+                h2 = windowHullVertices(W, Q.data());
+            // convexHullIndices() reports equal points twice
+            if (h == 2 && R[hull[0]].x == R[hull[1]].x && R[hull[0]].y == R[hull[1]].y)
+                h = 1;
+            ok &= (h == h2 && windowHullCount(W) == (int)S.size());
+            for (int j=0; ok && j<h; j++)
+                ok &= (R[hull[j]].x == Q[j].x && R[hull[j]].y == Q[j].y);
+        }
+        ok &= (windowHullExpire(W, NUMBER_OF_POINTS) == (int)S.size());
+        ok &= (windowHullVertices(W, NULL) == 0);
+        windowHullFree(W);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Random points in a ball, a small cube (many coplanar points) or a plane
+static int randomPoints3(point3 *P, int n, int run) {
+    for (int i=0; i<n; i++) {
+        if (run % 3 == 0) {
+            do {
+                P[i].x = rand() % 2000001 - 1000000;
+                P[i].y = rand() % 2000001 - 1000000;
+                P[i].z = rand() % 2000001 - 1000000;
+            } while ((double)P[i].x*P[i].x + (double)P[i].y*P[i].y + (double)P[i].z*P[i].z > 1e12);
+        } else if (run % 3 == 1) {
+            P[i].x = rand() % 6;
+            P[i].y = rand() % 6;
+            P[i].z = rand() % 6;
+        } else {
+            P[i].x = rand() % 100;
+            P[i].y = rand() % 100;
+            P[i].z = 2*P[i].x - 3*P[i].y + 7;
+        }
+    }
+    return n;
+}
+
+static int orient3(const point3 &a, const point3 &b, const point3 &c, const point3 &d) {
+    typedef __int128 i128;
+    i128 bx = (i128)b.x-a.x, by = (i128)b.y-a.y, bz = (i128)b.z-a.z, cx = (i128)c.x-a.x,
+         cy = (i128)c.y-a.y, cz = (i128)c.z-a.z, dx = (i128)d.x-a.x, dy = (i128)d.y-a.y,
+         dz = (i128)d.z-a.z, det = bx*(cy*dz - cz*dy) - by*(cx*dz - cz*dx) + bz*(cx*dy - cy*dx);
+    return (det > 0) - (det < 0);
+}
+
+// Checks that H is a closed surface (Euler's formula and matching twins)
+// with no point above any of its faces
+static bool isConvexHull3(const point3 *P, int n, const hull3 &H) {
+    std::vector<bool> used(n);
+    int V = 0;
+    for (int e=0; e<3*H.faces; e++) {
+        int t = H.twin[e], next = e - e%3 + (e+1)%3, tnext = t - t%3 + (t+1)%3;
+        if (H.twin[t] != e || H.vertex[t] != H.vertex[next] || H.vertex[tnext] != H.vertex[e])
+            return false;
+        if (!used[H.vertex[e]]) V++;
+        used[H.vertex[e]] = true;
+    }
+    if (V - 3*H.faces/2 + H.faces != 2)
+        return false;
+    for (int f=0; f<H.faces; f++) {
+        const int *v = &H.vertex[3*f];
+        for (int i=0; i<n; i++)
+            if (orient3(P[v[0]], P[v[1]], P[v[2]], P[i]) > 0)
+                return false;
+    }
+    return true;
+}
+
+int test_hull3d(void) {
+    THEAD("convexHull3d() computes CH(P) in space");
+    bool ok = true;
+    std::vector<point3> P(NUMBER_OF_POINTS);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints3(P.data(), 4 + rand() % (NUMBER_OF_POINTS-4), run);
+        hull3 H;
+        ok &= convexHull3d(P.data(), n, &H) > 0 && isConvexHull3(P.data(), n, H);
+        convexHull3dFree(&H);
+    }
+    // Parallel mode: same vertices for points in general position
+    std::vector<point3> Q(100000);
+    for (int run=0; run<3 && ok; run++) {
+        int n = randomPoints3(Q.data(), Q.size(), 3*run);
+        hull3 H, H2;
+        int faces = convexHull3d(Q.data(), n, &H),
+            faces2 = convexHull3dParallel(Q.data(), n, &H2, 4);
+        ok &= faces == faces2 && faces > 0;
+        std::vector<bool> vertex(n), vertex2(n);
+        for (int e=0; ok && e<3*faces; e++) {
+            vertex[H.vertex[e]] = true;
+            vertex2[H2.vertex[e]] = true;
+        }
+        ok &= vertex == vertex2;
+        convexHull3dFree(&H);
+        convexHull3dFree(&H2);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// The template hull, for a given coordinate type, agrees with convexhull.c
+template <class T>
+int test_template(const char *desc) {
+    THEAD(desc);
+    bool ok = true;
+    std::vector<point> P(NUMBER_OF_POINTS);
+    std::vector<Point2<T>> Q(NUMBER_OF_POINTS);
+    std::vector<int> hull(NUMBER_OF_POINTS+1);
+    std::vector<std::size_t> hull2(NUMBER_OF_POINTS+1);
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomPoints(P.data(), run);
+        // 64 bit ints are also mapped to 2P - c, scaled (which keeps every
+        // orientation) to +-2^63, so the differences of coordinates take 65
+        // bits and the orientation determinants up to 130
+        long long a = 1, c = 0, scale = 1;
+        if (std::is_integral<T>::value && sizeof(T) == 8 && run % 4 >= 2) {
+            long long m = 1;
+            a = 2;
+            c = (run % 2 ? 0 : 7);
+            for (int i=0; i<n; i++)
+                m = std::max(m, std::max(std::abs(2LL*P[i].x - c), std::abs(2LL*P[i].y - c)));
+            scale = INT64_MAX / m;
+        }
+        for (int i=0; i<n; i++)
+            Q[i] = Point2<T> { T((a*P[i].x - c) * scale), T((a*P[i].y - c) * scale) };
+        std::vector<Point2<T>> R(Q.begin(), Q.begin()+n);
+        int h = convexHullIndices(P.data(), n, hull.data());
+        std::size_t h2 = compgeo::convexHull(Q.data(), n, hull2.data());
+        std::vector<std::size_t> hull3 = compgeo::convexHullIndexed(R.data(), n);
+        ok &= (std::size_t)h == h2 && h2 == hull3.size();
+        for (int i=0; ok && i<h; i++) {
+            ok &= (T((a*P[hull[i]].x - c) * scale) == Q[hull2[i]].x &&
+                   T((a*P[hull[i]].y - c) * scale) == Q[hull2[i]].y);
+            ok &= (R[hull3[i]].x == Q[hull2[i]].x && R[hull3[i]].y == Q[hull2[i]].y);
+        }
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// A point file of the given coordinate type maps back to the same hull
+template <class T>
+static bool pointFileRoundTrip(compgeo::CoordType type, int run) {
+    std::vector<point> P(NUMBER_OF_POINTS);
+    int n = randomPoints(P.data(), run);
+    std::vector<Point2<T>> Q(n);
+    for (int i=0; i<n; i++)
+        Q[i] = Point2<T> { T(P[i].x), T(P[i].y) };
+    char points[] = "/tmp/convexhull_testXXXXXX";
+    int fd = mkstemp(points);
+    if (fd < 0) return false;
+    close(fd);
+    std::string index = std::string(points) + ".idx";
+    compgeo::MappedPoints file;
+    std::vector<std::uint64_t> read;
+    std::uint64_t count = 0;
+    bool ok = compgeo::writePointFile(points, type, Q.data(), n) && file.open(points)
+              && file.type() == type && file.size() == (std::uint64_t)n;
+    if (ok) {
+        std::vector<std::uint64_t> hull = compgeo::convexHullFiltered<Point2<T>, std::uint64_t>(file.points<T>(), n),
+                                   hull2 = compgeo::convexHullIndexed<Point2<T>, std::uint64_t>(Q.data(), n);
+        // Equal points may be reported by another index
+        ok = (hull.size() == hull2.size());
+        for (std::size_t i=0; ok && i<hull.size(); i++)
+            ok = (Q[hull[i]].x == Q[hull2[i]].x && Q[hull[i]].y == Q[hull2[i]].y);
+        ok = ok && compgeo::writeIndexFile(index.c_str(), hull, n)
+             && compgeo::readIndexFile(index.c_str(), read, &count)
+             && read == hull && count == (std::uint64_t)n;
+        // A corrupt count or a truncated file fails instead of allocating
+        std::uint64_t corrupt = std::uint64_t(1) << 62;
+        fd = open(index.c_str(), O_WRONLY);
+        ok = ok && fd >= 0 && pwrite(fd, &corrupt, sizeof(corrupt), offsetof(compgeo::IndexFileHeader, count))
+                              == ssize_t(sizeof(corrupt));
+        ok = ok && close(fd) == 0 && !compgeo::readIndexFile(index.c_str(), read);
+        ok = ok && compgeo::writeIndexFile(index.c_str(), hull, n)
+             && truncate(index.c_str(), sizeof(compgeo::IndexFileHeader) + 4*hull.size() - 1) == 0
+             && !compgeo::readIndexFile(index.c_str(), read);
+    }
+    file.close();
+    unlink(points);
+    unlink(index.c_str());
+    return ok;
+}
+
+int test_pointFile(void) {
+    THEAD("Mapped point files and convexHullFiltered()");
+    bool ok = true;
+    for (int run=0; run<RUNS/10 && ok; run++) {
+        ok &= pointFileRoundTrip<int32_t>(compgeo::CoordType::Int32, run);
+        ok &= pointFileRoundTrip<float>(compgeo::CoordType::Float, run);
+        ok &= pointFileRoundTrip<double>(compgeo::CoordType::Double, run);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int tests = 0, succeses = 0;
+    printf("===============================\n");
+    printf("Testing:\n");
+    tests++; succeses += test_indices();
+    tests++; succeses += test_largeCoordinates();
+    tests++; succeses += test_sortPoints();
+    tests++; succeses += test_prefilter();
+    tests++; succeses += test_parallel();
+    tests++; succeses += test_chan();
+    tests++; succeses += test_batch();
+    tests++; succeses += test_context();
+    tests++; succeses += test_external();
+    tests++; succeses += test_query();
+    tests++; succeses += test_calipers();
+    tests++; succeses += test_kernel();
+    tests++; succeses += test_online();
+    tests++; succeses += test_dynamic();
+    tests++; succeses += test_window();
+    tests++; succeses += test_hull3d();
+    tests++; succeses += test_template<int32_t>("Template hull (int32)");
+    tests++; succeses += test_template<int64_t>("Template hull (int64)");
+    tests++; succeses += test_template<float>("Template hull (float)");
+    tests++; succeses += test_template<double>("Template hull (double)");
+    tests++; succeses += test_pointFile();
+    printf("===============================\n");
+    printf("Performed %3d tests:\n", tests);
+    printf("\t  %3d failures\n", tests-succeses);
+    printf("\t  %3d succeses\n", succeses);
+    return (tests != succeses);
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include "../pointfile.hpp"
+
+/**
+ * Computes the convex hull of a binary point file (see pointfile.hpp) on the
+ * memory mapped points, and writes the indices of its vertices to an index
+ * file. With -g the point file is first filled with random points in a disk.
+ */
+
+using namespace compgeo;
+
+static void printUsage(void) {
+    std::fprintf(stderr,
+        "Usage: hullfile [options] POINTS [INDEX]\n"
+        "\t-g N     first write N random points in a disk to POINTS\n"
+        "\t-t TYPE  coordinate type of the generated points: int32, float or double\n"
+        "\t         (default: int32)\n"
+        "The hull is written to INDEX, or only counted if INDEX is missing.\n");
+}
+
+static double seconds(void) {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+template <class T>
+static bool generate(const char *path, std::uint64_t n, CoordType type) {
+    std::vector<Point2<T>> pts(n);
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (auto &p : pts) {
+        double r = 1e6 * std::sqrt(uniform(rng)), t = 2 * M_PI * uniform(rng);
+        p.x = T(r * std::cos(t));
+        p.y = T(r * std::sin(t));
+    }
+    return writePointFile(path, type, pts.data(), n);
+}
+
+template <class T>
+static std::vector<std::uint64_t> hull(const MappedPoints &file) {
+    // Both passes of convexHullFiltered() are sequential scans
+    file.adviseSequential();
+    return convexHullFiltered<Point2<T>, std::uint64_t>(file.points<T>(), file.size());
+}
+
+int main(int argc, char **argv) {
+    long long generated = -1;
+    CoordType type = CoordType::Int32;
+    int opt;
+    while ((opt = getopt(argc, argv, "g:t:h")) != -1) {
+        switch (opt) {
+            case 'g': generated = atof(optarg); break;
+            case 't':
+                type = (!std::strcmp(optarg, "double") ? CoordType::Double :
+                        !std::strcmp(optarg, "float") ? CoordType::Float : CoordType::Int32);
+                break;
+            default:
+                printUsage();
+                return (opt != 'h');
+        }
+    }
+    if (optind >= argc) {
+        printUsage();
+        return 1;
+    }
+    const char *pointPath = argv[optind],
+               *indexPath = (optind+1 < argc ? argv[optind+1] : nullptr);
+
+    if (generated >= 0) {
+        bool ok = (type == CoordType::Int32 ? generate<std::int32_t>(pointPath, generated, type) :
+                   type == CoordType::Float ? generate<float>(pointPath, generated, type) :
+                                              generate<double>(pointPath, generated, type));
+        if (!ok) {
+            std::perror(pointPath);
+            return 1;
+        }
+    }
+
+    MappedPoints file;
+    if (!file.open(pointPath)) {
+        std::fprintf(stderr, "%s: %s\n", pointPath, file.error());
+        return 1;
+    }
+    double t = seconds();
+    std::vector<std::uint64_t> h;
+    switch (file.type()) {
+        case CoordType::Int32: h = hull<std::int32_t>(file); break;
+        case CoordType::Float: h = hull<float>(file); break;
+        case CoordType::Double: h = hull<double>(file); break;
+    }
+    t = seconds() - t;
+    std::printf("%llu points, %zu hull vertices, %.3f s\n",
+                (unsigned long long)file.size(), h.size(), t);
+    if (indexPath != nullptr && !writeIndexFile(indexPath, h, file.size())) {
+        std::perror(indexPath);
+        return 1;
+    }
+    return 0;
+}
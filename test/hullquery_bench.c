@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200112L // clock_gettime, getopt
+#include <time.h>
+#include <unistd.h>
+#include "../convexhull.h"
+#include "../hullquery.h"
+
+/**
+ * Headless benchmark of the hull queries of hullquery.c: containment,
+ * extreme vertices and tangents, on the hull of points in a disk (few
+ * vertices) or on a circle (every point a vertex). The queries are points
+ * in the bounding square of the hull and random directions, and the
+ * results are written as CSV to stdout.
+ */
+
+#define RADIUS 1000000
+
+static void printUsage(void) {
+    fprintf(stderr,
+        "Usage: hullquery_bench [options]\n"
+        "\t-n N     number of points of the hull (default: 1000000)\n"
+        "\t-q Q     number of queries (default: 10000000)\n"
+        "\t-c       points on a circle instead of in a disk\n"
+        "\t-s SEED  random seed (default: 1)\n");
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static double uniform(void) {
+    return (double)rand() / RAND_MAX;
+}
+
+int main(int argc, char **argv) {
+    long long n = 1000000, queries = 10000000;
+    int circle = false, opt;
+    unsigned seed = 1;
+    while ((opt = getopt(argc, argv, "n:q:cs:h")) != -1) {
+        switch (opt) {
+            case 'n': n = atof(optarg); break;
+            case 'q': queries = atof(optarg); break;
+            case 'c': circle = true; break;
+            case 's': seed = atoi(optarg); break;
+            default:
+                printUsage();
+                return (opt != 'h');
+        }
+    }
+    n = max(1, min(n, INT32_MAX - 1));
+    queries = max(1, min(queries, INT32_MAX));
+    srand(seed);
+
+    point *P = malloc(n*sizeof(point));
+    int *hull = malloc((n+1)*sizeof(int)),
+        *x = malloc(queries*sizeof(int)), *y = malloc(queries*sizeof(int)),
+        *left = malloc(queries*sizeof(int)), *right = malloc(queries*sizeof(int));
+    double *dx = malloc(queries*sizeof(double)), *dy = malloc(queries*sizeof(double));
+    unsigned char *inside = malloc(queries);
+    if (P == NULL || hull == NULL || x == NULL || y == NULL || left == NULL
+            || right == NULL || dx == NULL || dy == NULL || inside == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (circle) {
+        for (int i=0; i<n; i++) {
+            double t = 2 * 3.14159265 * uniform();
+            P[i].x = RADIUS * cos(t);
+            P[i].y = RADIUS * sin(t);
+        }
+    } else {
+        randomDiskPoints(P, n, 0, 0, RADIUS);
+    }
+    int h = convexHullIndices(P, n, hull);
+    double t = seconds();
+    hullQuery *Q = hullQueryInit(P, hull, h);
+    double build = seconds() - t;
+    for (int i=0; i<queries; i++) {
+        x[i] = RADIUS * (2*uniform() - 1);
+        y[i] = RADIUS * (2*uniform() - 1);
+        double a = 2 * 3.14159265 * uniform();
+        dx[i] = cos(a);
+        dy[i] = sin(a);
+    }
+
+    printf("query,n,h,queries,total_s,queries_per_s\n");
+    printf("build,%lld,%d,%d,%.6f,\n", n, h, 1, build);
+    t = seconds();
+    hullQueryContainsBatch(Q, x, y, queries, inside);
+    t = seconds() - t;
+    printf("contains,%lld,%d,%lld,%.6f,%.0f\n", n, h, queries, t, queries / t);
+    t = seconds();
+    hullQueryExtremeBatch(Q, dx, dy, queries, left);
+    t = seconds() - t;
+    printf("extreme,%lld,%d,%lld,%.6f,%.0f\n", n, h, queries, t, queries / t);
+    t = seconds();
+    hullQueryTangentsBatch(Q, x, y, queries, left, right);
+    t = seconds() - t;
+    printf("tangents,%lld,%d,%lld,%.6f,%.0f\n", n, h, queries, t, queries / t);
+
+    hullQueryFree(Q);
+    free(P);
+    free(hull);
+    free(x);
+    free(y);
+    free(left);
+    free(right);
+    free(dx);
+    free(dy);
+    free(inside);
+    return 0;
+}
@@ -0,0 +1,169 @@
+#define _POSIX_C_SOURCE 200112L // clock_gettime, getopt
+#include <time.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <vector>
+#include "../linsegintersect.h"
+
+/**
+ * Headless benchmark of the segment intersection modes on several
+ * distributions of segments. Sizes go from -n to -N in steps of 10, and
+ * results are written as CSV to stdout; k is the number of pairs found (for
+ * the any mode, 1 if there is one). The parallel mode is run with 1, 2, 4...
+ * up to -t threads, for its scaling (with 1 it is the pairs mode).
+ *   - short: segments of length about 2 RADIUS/sqrt(n), so O(n) pairs
+ *   - disjoint: segments in rows of their own, no pairs (the any mode has to
+ *     sweep all of them)
+ *   - crossing: disjoint, and one segment across all rows diagonally (the
+ *     any mode stops near the left end)
+ */
+
+#define RADIUS 1000000
+
+static void printUsage(void) {
+    fprintf(stderr,
+        "Usage: linsegintersect_bench [options]\n"
+        "\t-d LIST  distributions: short,disjoint,crossing (default: all)\n"
+        "\t-m LIST  modes: pairs,points,count,any,parallel (default: all)\n"
+        "\t-t T     most threads of the parallel mode (default: 64)\n"
+        "\t-n N     smallest number of segments (default: 1000)\n"
+        "\t-N N     largest number of segments (default: 1000000)\n"
+        "\t-r R     repetitions, the fastest is reported (default: 1)\n"
+        "\t-s SEED  random seed (default: 1)\n");
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int uniform(int size) {
+    return (int)((double)rand() / ((double)RAND_MAX + 1) * size);
+}
+
+static void shortSegments(lineSegment *S, int n) {
+    int length = (int)(2 * RADIUS / sqrt((double)n)) + 1;
+    for (int i=0; i<n; i++) {
+        S[i].x1 = uniform(RADIUS);
+        S[i].y1 = uniform(RADIUS);
+        S[i].x2 = S[i].x1 + uniform(2*length) - length;
+        S[i].y2 = S[i].y1 + uniform(2*length) - length;
+    }
+}
+
+static void disjointSegments(lineSegment *S, int n) {
+    for (int i=0; i<n; i++) {
+        S[i].x1 = uniform(RADIUS);
+        S[i].x2 = uniform(RADIUS);
+        S[i].y1 = 4*i + uniform(4);
+        S[i].y2 = 4*i + uniform(4);
+    }
+}
+
+static void crossingSegments(lineSegment *S, int n) {
+    disjointSegments(S, n);
+    lineSegment crossing = { 0, -1, RADIUS, 4*n };
+    S[rand() % n] = crossing;
+}
+
+static const struct distribution {
+    const char *name;
+    void (*generate)(lineSegment *S, int n);
+} distributions[] = {
+    { "short", shortSegments },
+    { "disjoint", disjointSegments },
+    { "crossing", crossingSegments },
+};
+#define DISTRIBUTIONS (int)(sizeof(distributions) / sizeof(distributions[0]))
+
+enum mode { PAIRS, POINTS, COUNT, ANY, PARALLEL, MODES };
+static const char *modeNames[MODES] = { "pairs", "points", "count", "any", "parallel" };
+
+// Is name in the comma separated list (NULL is every name)?
+static bool inList(const char *list, const char *name) {
+    if (list == NULL) return true;
+    size_t len = strlen(name);
+    for (const char *s = list; (s = strstr(s, name)) != NULL; s += len)
+        if ((s == list || s[-1] == ',') && (s[len] == ',' || s[len] == '\0'))
+            return true;
+    return false;
+}
+
+static long runMode(mode m, const lineSegment *S, int n, int threads) {
+    int *pairs;
+    long k;
+    switch (m) {
+        case PAIRS:
+            k = segmentIntersectionPairs(S, n, &pairs);
+            free(pairs);
+            return k;
+        case PARALLEL:
+            k = segmentIntersectionPairsParallel(S, n, &pairs, threads);
+            free(pairs);
+            return k;
+        case POINTS:
+            return segmentIntersections(S, n, NULL, NULL);
+        case COUNT:
+            return segmentIntersectionCount(S, n);
+        case ANY:
+            return segmentIntersectionAny(S, n);
+        default:
+            return -1;
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *distributionList = NULL, *modeList = NULL;
+    long minN = 1000, maxN = 1000000;
+    int maxThreads = 64, repetitions = 1, seed = 1, opt;
+    while ((opt = getopt(argc, argv, "d:m:t:n:N:r:s:h")) != -1) {
+        switch (opt) {
+            case 'd': distributionList = optarg; break;
+            case 'm': modeList = optarg; break;
+            case 't': maxThreads = atoi(optarg); break;
+            case 'n': minN = atof(optarg); break;
+            case 'N': maxN = atof(optarg); break;
+            case 'r': repetitions = atoi(optarg); break;
+            case 's': seed = atoi(optarg); break;
+            default:
+                printUsage();
+                return (opt != 'h');
+        }
+    }
+    if (minN < 1 || maxN > INT_MAX/8 || maxThreads < 1 || repetitions < 1) {
+        printUsage();
+        return 1;
+    }
+
+    printf("distribution,mode,threads,n,k,seconds\n");
+    std::vector<lineSegment> S;
+    for (int d=0; d<DISTRIBUTIONS; d++) {
+        if (!inList(distributionList, distributions[d].name)) continue;
+        for (long n=minN; n<=maxN; n*=10) {
+            srand(seed);
+            S.resize(n);
+            distributions[d].generate(&S[0], n);
+            for (int m=0; m<MODES; m++) {
+                if (!inList(modeList, modeNames[m])) continue;
+                for (int threads=1; threads<=(m == PARALLEL ? maxThreads : 1); threads*=2) {
+                    double best = HUGE_VAL;
+                    long k = 0;
+                    for (int r=0; r<repetitions; r++) {
+                        double t0 = seconds();
+                        k = runMode((mode)m, &S[0], n, threads);
+                        best = fmin(best, seconds() - t0);
+                    }
+                    printf("%s,%s,%d,%ld,%ld,%.6f\n", distributions[d].name, modeNames[m],
+                           threads, n, k, best);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+#include <vector>
+#include <set>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include "../linsegintersect.h"
+
+#define RUNS 200
+#define NUMBER_OF_SEGMENTS 300
+
+#define THEAD(desc) printf("\ttest: %-40s", desc)
+#define TFOOT(ok) printf("\t      => %s\n", (ok?"SUCCESS":"FAIL"))
+
+typedef __int128 int128;
+typedef std::pair<int, int> segmentPair;
+
+// Random segments on a small grid (shared endpoints, vertical and collinear
+// segments, single points) or in a large square (general position)
+static int randomSegments(lineSegment *S, int run) {
+    int n = 1 + rand() % NUMBER_OF_SEGMENTS,
+        size = (run % 2 ? 100000 : 8);
+    for (int i=0; i<n; i++) {
+        S[i].x1 = rand() % size;
+        S[i].y1 = rand() % size;
+        S[i].x2 = (rand() % 4 == 0 ? S[i].x1 : rand() % size);
+        S[i].y2 = rand() % size;
+    }
+    return n;
+}
+
+static int orientation(long long ax, long long ay, long long bx, long long by,
+                       long long cx, long long cy) {
+    int128 det = (int128)(bx - ax) * (cy - ay) - (int128)(by - ay) * (cx - ax);
+    return (det > 0) - (det < 0);
+}
+
+// Is (cx, cy), on the line of segment s, within its bounding box?
+static bool onSegment(const lineSegment &s, long long cx, long long cy) {
+    return std::min(s.x1, s.x2) <= cx && cx <= std::max(s.x1, s.x2) &&
+           std::min(s.y1, s.y2) <= cy && cy <= std::max(s.y1, s.y2);
+}
+
+static bool bruteIntersects(const lineSegment &s, const lineSegment &t) {
+    int o1 = orientation(s.x1, s.y1, s.x2, s.y2, t.x1, t.y1),
+        o2 = orientation(s.x1, s.y1, s.x2, s.y2, t.x2, t.y2),
+        o3 = orientation(t.x1, t.y1, t.x2, t.y2, s.x1, s.y1),
+        o4 = orientation(t.x1, t.y1, t.x2, t.y2, s.x2, s.y2);
+    if (o1 * o2 < 0 && o3 * o4 < 0) return true;
+    return (o1 == 0 && onSegment(s, t.x1, t.y1)) || (o2 == 0 && onSegment(s, t.x2, t.y2)) ||
+           (o3 == 0 && onSegment(t, s.x1, s.y1)) || (o4 == 0 && onSegment(t, s.x2, s.y2));
+}
+
+static std::set<segmentPair> brutePairs(const lineSegment *S, int n) {
+    std::set<segmentPair> pairs;
+    for (int i=0; i<n; i++)
+        for (int j=i+1; j<n; j++)
+            if (bruteIntersects(S[i], S[j]))
+                pairs.insert(segmentPair(i, j));
+    return pairs;
+}
+
+static bool samePairs(const lineSegment *S, int n) {
+    int *pairs;
+    long k = segmentIntersectionPairs(S, n, &pairs);
+    std::set<segmentPair> found;
+    for (long i=0; i<k; i++)
+        found.insert(segmentPair(pairs[2*i], pairs[2*i+1]));
+    free(pairs);
+    // Every pair exactly once
+    return (long)found.size() == k && found == brutePairs(S, n);
+}
+
+int test_pairs(void) {
+    THEAD("Intersecting pairs (brute force)");
+    std::vector<lineSegment> S(NUMBER_OF_SEGMENTS);
+    bool ok = true;
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = randomSegments(&S[0], run);
+        ok = samePairs(&S[0], n);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+struct pointCounts {
+    std::map<std::pair<double, double>, int> count;
+    double lastX, lastY;
+    bool sorted;
+};
+
+static void countPoint(void *context, const struct segmentIntersection *I) {
+    pointCounts *C = (pointCounts*)context;
+    if (I->x < C->lastX || (I->x == C->lastX && I->y <= C->lastY))
+        C->sorted = false;
+    C->lastX = I->x;
+    C->lastY = I->y;
+    C->count[std::make_pair(I->x, I->y)] = I->count;
+}
+
+static long long gcd(long long a, long long b) {
+    return (b == 0 ? (a < 0 ? -a : a) : gcd(b, a % b));
+}
+
+// A rational point X/D, Y/D in lowest terms (D > 0)
+struct rational {
+    long long X, Y, D;
+    rational(long long x, long long y, long long d) {
+        long long g = gcd(gcd(x, y), d) * (d < 0 ? -1 : 1);
+        X = x / g;
+        Y = y / g;
+        D = d / g;
+    }
+    bool operator<(const rational &r) const {
+        return X != r.X ? X < r.X : (Y != r.Y ? Y < r.Y : D < r.D);
+    }
+};
+
+static bool contains(const lineSegment &s, const rational &p) {
+    int128 det = (int128)(s.x2 - s.x1) * (p.Y - (int128)s.y1 * p.D) -
+                 (int128)(s.y2 - s.y1) * (p.X - (int128)s.x1 * p.D);
+    return det == 0 &&
+           (int128)std::min(s.x1, s.x2) * p.D <= p.X && p.X <= (int128)std::max(s.x1, s.x2) * p.D &&
+           (int128)std::min(s.y1, s.y2) * p.D <= p.Y && p.Y <= (int128)std::max(s.y1, s.y2) * p.D;
+}
+
+// The points where two or more segments meet, with the number of segments
+static std::map<rational, int> brutePoints(const lineSegment *S, int n) {
+    std::set<rational> candidates;
+    for (int i=0; i<n; i++) {
+        candidates.insert(rational(S[i].x1, S[i].y1, 1));
+        candidates.insert(rational(S[i].x2, S[i].y2, 1));
+        for (int j=i+1; j<n; j++) {
+            long long dxs = S[i].x2 - S[i].x1, dys = S[i].y2 - S[i].y1,
+                      dxt = S[j].x2 - S[j].x1, dyt = S[j].y2 - S[j].y1,
+                      den = dxs*dyt - dys*dxt,
+                      u = (long long)(S[j].x1 - S[i].x1)*dyt - (long long)(S[j].y1 - S[i].y1)*dxt;
+            if (den != 0 && bruteIntersects(S[i], S[j]))
+                candidates.insert(rational(S[i].x1*den + u*dxs, S[i].y1*den + u*dys, den));
+        }
+    }
+    std::map<rational, int> points;
+    for (std::set<rational>::iterator p=candidates.begin(); p!=candidates.end(); ++p) {
+        int through = 0;
+        for (int i=0; i<n; i++)
+            through += contains(S[i], *p);
+        if (through > 1)
+            points[*p] = through;
+    }
+    return points;
+}
+
+int test_points(void) {
+    THEAD("Intersection points (brute force)");
+    std::vector<lineSegment> S(NUMBER_OF_SEGMENTS);
+    bool ok = true;
+    for (int run=0; run<RUNS/4 && ok; run++) {
+        int n = randomSegments(&S[0], run);
+        pointCounts C;
+        C.lastX = C.lastY = -1;
+        C.sorted = true;
+        long points = segmentIntersections(&S[0], n, countPoint, &C);
+        std::map<rational, int> expected = brutePoints(&S[0], n);
+        ok = C.sorted && points == (long)expected.size() && points == (long)C.count.size() &&
+             segmentIntersections(&S[0], n, NULL, NULL) == points;
+        for (std::map<rational, int>::iterator p=expected.begin(); p!=expected.end() && ok; ++p) {
+            std::pair<double, double> xy((double)((long double)p->first.X / p->first.D),
+                                         (double)((long double)p->first.Y / p->first.D));
+            ok = (C.count[xy] == p->second);
+        }
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Segments through one point, some ending there, some vertical or overlapping
+int test_degenerate(void) {
+    THEAD("Many segments through one point");
+    std::vector<lineSegment> S;
+    for (int i=-10; i<=10; i++) {
+        lineSegment through = { -100, -10*i, 100, 10*i }, ending = { 0, 0, 50, 7*i+1 };
+        S.push_back(through);
+        S.push_back(ending);
+    }
+    lineSegment vertical = { 0, -500, 0, 500 }, below = { 0, -700, 0, -500 },
+                point = { 0, 0, 0, 0 }, overlap = { -100, 100, 0, 0 };
+    S.push_back(vertical);
+    S.push_back(below);
+    S.push_back(point);
+    S.push_back(overlap);
+    int n = S.size();
+    pointCounts C;
+    C.lastX = C.lastY = -HUGE_VAL;
+    C.sorted = true;
+    segmentIntersections(&S[0], n, countPoint, &C);
+    // All but below meet at the origin
+    bool ok = C.sorted && samePairs(&S[0], n) && C.count[std::make_pair(0.0, 0.0)] == n-1;
+    TFOOT(ok);
+    return ok;
+}
+
+int test_largeCoordinates(void) {
+    THEAD("Intersections of large coordinates");
+    std::vector<lineSegment> S(NUMBER_OF_SEGMENTS);
+    bool ok = true;
+    for (int run=0; run<RUNS/4 && ok; run++) {
+        int n = randomSegments(&S[0], run);
+        for (int i=0; i<n; i++) {
+            int *c[4] = { &S[i].x1, &S[i].y1, &S[i].x2, &S[i].y2 };
+            for (int k=0; k<4; k++) {
+                int v = *c[k];
+                *c[k] = (v % 2 ? INT_MAX - (v % 8) : INT_MIN + (v % 8));
+                if (run % 2)
+                    *c[k] = (int)((long long)v * (INT_MAX / 100000) - INT_MAX / 2);
+            }
+        }
+        ok = samePairs(&S[0], n);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Segments in bands of their own, so none meet, or one more that crosses
+// some of them (run % 4 == 1) or touches one at an endpoint (run % 4 == 3)
+static int disjointSegments(lineSegment *S, int run) {
+    int n = 1 + rand() % (NUMBER_OF_SEGMENTS - 1), band = 100;
+    for (int i=0; i<n; i++) {
+        S[i].x1 = rand() % 100000;
+        S[i].y1 = i*band + rand() % band;
+        S[i].x2 = (rand() % 4 == 0 ? S[i].x1 : rand() % 100000);
+        S[i].y2 = i*band + rand() % band;
+    }
+    if (run % 4 == 1) {
+        lineSegment crossing = { rand() % 100000, -1, rand() % 100000, n*band };
+        S[n++] = crossing;
+    } else if (run % 4 == 3) {
+        int i = rand() % n;
+        lineSegment touching = { S[i].x2, S[i].y2, S[i].x2 + 1, S[i].y2 - band };
+        S[n++] = touching;
+    }
+    return n;
+}
+
+int test_count(void) {
+    THEAD("Count and any intersection (brute force)");
+    std::vector<lineSegment> S(NUMBER_OF_SEGMENTS);
+    bool ok = true;
+    for (int run=0; run<RUNS && ok; run++) {
+        int n = (run % 3 ? randomSegments(&S[0], run) : disjointSegments(&S[0], run / 3));
+        long pairs = (long)brutePairs(&S[0], n).size();
+        ok = segmentIntersectionCount(&S[0], n) == pairs &&
+             segmentIntersectionAny(&S[0], n) == (pairs > 0);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+// Many short segments on a grid, so many meet on the bounds of slabs
+int test_parallel(void) {
+    THEAD("Parallel pairs (sequential)");
+    bool ok = true;
+    for (int run=0; run<RUNS/20 && ok; run++) {
+        int n = 20000 + rand() % 20000, size = 2000, length = (run % 2 ? 10 : 50);
+        std::vector<lineSegment> S(n);
+        for (int i=0; i<n; i++) {
+            S[i].x1 = rand() % size;
+            S[i].y1 = rand() % size;
+            S[i].x2 = (rand() % 4 == 0 ? S[i].x1 : S[i].x1 + rand() % length - length/2);
+            S[i].y2 = S[i].y1 + rand() % length - length/2;
+        }
+        int *pairs, *expected;
+        long k = segmentIntersectionPairsParallel(&S[0], n, &pairs, 2 + rand() % 63),
+             m = segmentIntersectionPairs(&S[0], n, &expected);
+        std::set<segmentPair> found, all;
+        for (long i=0; i<k; i++)
+            found.insert(segmentPair(pairs[2*i], pairs[2*i+1]));
+        for (long i=0; i<m; i++)
+            all.insert(segmentPair(expected[2*i], expected[2*i+1]));
+        ok = k == m && (long)found.size() == k && found == all;
+        free(pairs);
+        free(expected);
+    }
+    TFOOT(ok);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int tests = 0, succeses = 0;
+    printf("===============================\n");
+    printf("Testing:\n");
+    tests++; succeses += test_pairs();
+    tests++; succeses += test_points();
+    tests++; succeses += test_degenerate();
+    tests++; succeses += test_largeCoordinates();
+    tests++; succeses += test_count();
+    tests++; succeses += test_parallel();
+    printf("===============================\n");
+    printf("Performed %3d tests:\n", tests);
+    printf("\t  %3d failures\n", tests-succeses);
+    printf("\t  %3d succeses\n", succeses);
+    return (tests != succeses);
+}
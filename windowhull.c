@@ -0,0 +1,331 @@
+#include "windowhull.h"
+#include "hullpart.h"
+
+/**
+ * Sliding window convex hull: the hull of the points of a queue.
+ * Hull parts are maintained by insertPart() of hullpart.c, which only
+ * supports insertions, so the queue is made of two stacks (a banker's queue):
+ *   - Pushing a point inserts it into the back hull.
+ *   - The front hull is built from the back points, newest to oldest, and
+ *     every insertion logs the nodes it adds and removes. The oldest point
+ *     is inserted last, so popping it is undoing the last insertion.
+ * Every point is inserted into the back, moved to the front and undone once,
+ * and each of these costs O(log n) amortized time, as every node removed by
+ * an insertion was added before (and is added back at most once by an undo).
+ * A query merges the two hulls in time linear in their size.
+ */
+
+#define NODE_CHUNK 1024
+
+// A tree node together with its point, so the node is the only allocation
+struct vertexNode {
+    RBNode node;
+    point p;
+};
+
+struct windowNodes {
+    struct windowNodes *next;
+    struct vertexNode nodes[NODE_CHUNK];
+};
+
+// What inserting a point into the front did to each part, for undoing it
+struct windowUndo {
+    RBNode *added[2];   // the node of the point, or NULL if not a vertex
+    int removed[2];     // number of nodes it removed (on top of W->removed)
+};
+
+// Makes sure that at least k nodes are free
+static int reserveNodes(windowHull *W, int k) {
+    while (W->freeCount < k) {
+        struct windowNodes *chunk = malloc(sizeof(struct windowNodes));
+        if (chunk == NULL) return false;
+        chunk->next = W->chunks;
+        W->chunks = chunk;
+        for (int i=0; i<NODE_CHUNK; i++) {
+            chunk->nodes[i].node.right = W->freeNodes;
+            W->freeNodes = &chunk->nodes[i].node;
+        }
+        W->freeCount += NODE_CHUNK;
+    }
+    return true;
+}
+
+// Takes a reserved node
+static RBNode *newVertex(void *context, const point *p) {
+    windowHull *W = context;
+    RBNode *x = W->freeNodes;
+    struct vertexNode *v = (struct vertexNode *)x;
+    W->freeNodes = x->right;
+    W->freeCount--;
+    v->p = *p;
+    x->key = p->x;
+    x->data = &v->p;
+    return x;
+}
+
+static void freeVertex(void *context, RBNode *x) {
+    windowHull *W = context;
+    x->right = W->freeNodes;
+    W->freeNodes = x;
+    W->freeCount++;
+}
+
+// Inserts p into one part using one reserved node; unless removed is NULL,
+// the nodes it removes are logged in W->removed and counted in removed
+static RBNode *insertVertex(windowHull *W, RBTree *T, int side, const point *p, int *removed) {
+    struct partNodes nodes = { newVertex, freeVertex, W };
+    if (removed == NULL)
+        return insertPart(T, side, p, &nodes, NULL, NULL);
+    int size = W->removedSize;
+    RBNode *z = insertPart(T, side, p, &nodes, W->removed, &W->removedSize);
+    *removed = W->removedSize - size;
+    return z;
+}
+
+// Undoes an insertion into a part of the front
+static void undoPart(windowHull *W, RBTree *T, RBNode *added, int removed) {
+    if (added != NULL) {
+        RBdelete(T, added);
+        freeVertex(W, added);
+    }
+    while (removed-- > 0)
+        RBinsert(T, W->removed[--W->removedSize]);
+}
+
+// Undoes the insertion of the oldest point of the front
+static void undoFront(windowHull *W) {
+    struct windowUndo *u = &W->undo[--W->frontCount];
+    undoPart(W, W->front.lower, u->added[1], u->removed[1]);
+    undoPart(W, W->front.upper, u->added[0], u->removed[0]);
+}
+
+static void clearSubtree(windowHull *W, RBTree *T, RBNode *x) {
+    if (RBisLeaf(T, x)) return;
+    clearSubtree(W, T, x->left);
+    clearSubtree(W, T, x->right);
+    freeVertex(W, x);
+}
+
+static void clearTree(windowHull *W, RBTree *T) {
+    clearSubtree(W, T, T->root);
+    T->root = T->nil;
+}
+
+static struct windowEntry *entry(windowHull *W, int i) {
+    return &W->entries[(W->head + i) % W->capacity];
+}
+
+/**
+ * Moves the points of the back to the front (which is empty).
+ * @return false if out of memory, leaving the window as it was
+ */
+static int refillFront(windowHull *W) {
+    for (int i=W->count-1; i>=0; i--) {
+        if (!reserveNodes(W, 2)) {
+            while (W->frontCount > 0)
+                undoFront(W);
+            return false;
+        }
+        struct windowUndo *u = &W->undo[W->frontCount++];
+        const point *p = &entry(W, i)->p;
+        u->added[0] = insertVertex(W, W->front.upper, UPPER, p, &u->removed[0]);
+        u->added[1] = insertVertex(W, W->front.lower, LOWER, p, &u->removed[1]);
+    }
+    clearTree(W, W->back.upper);
+    clearTree(W, W->back.lower);
+    return true;
+}
+
+// Doubles the room for points, with the undo log that goes with them
+static int growWindow(windowHull *W) {
+    int capacity = (W->capacity > 0 ? 2*W->capacity : 64);
+    struct windowEntry *entries = malloc(capacity*sizeof(struct windowEntry));
+    struct windowUndo *undo = realloc(W->undo, capacity*sizeof(struct windowUndo));
+    if (undo != NULL) W->undo = undo;
+    // Every point has at most one node in each part, removed at most once
+    RBNode **removed = realloc(W->removed, 2*capacity*sizeof(RBNode *));
+    if (removed != NULL) W->removed = removed;
+    if (entries == NULL || undo == NULL || removed == NULL) {
+        free(entries);
+        return false;
+    }
+    for (int i=0; i<W->count; i++)
+        entries[i] = *entry(W, i);
+    free(W->entries);
+    W->entries = entries;
+    W->head = 0;
+    W->capacity = capacity;
+    return true;
+}
+
+static int initPart(struct windowPart *H) {
+    H->upper = RBinit();
+    H->lower = RBinit();
+    return H->upper != NULL && H->lower != NULL;
+}
+
+static void freeTree(RBTree *T) {
+    if (T == NULL) return;
+    free(T->nil);
+    free(T);
+}
+
+/**
+ * Creates an empty window.
+ * @return The window, to be released with windowHullFree(), or NULL
+ */
+windowHull *windowHullInit(void) {
+    windowHull *W = calloc(1, sizeof(windowHull));
+    if (W == NULL) return NULL;
+    if (!initPart(&W->front) || !initPart(&W->back)) {
+        windowHullFree(W);
+        return NULL;
+    }
+    return W;
+}
+
+/**
+ * Adds a point at the back of the window in O(log n) amortized time.
+ * @param  W    The window
+ * @param  p    The new point
+ * @param  time Its time stamp (non-decreasing), see windowHullExpire()
+ * @return      false if out of memory
+ */
+int windowHullPush(windowHull *W, point p, double time) {
+    if (W->count == W->capacity && !growWindow(W))
+        return false;
+    if (!reserveNodes(W, 2))
+        return false;
+    struct windowEntry *e = &W->entries[(W->head + W->count++) % W->capacity];
+    e->p = p;
+    e->time = time;
+    insertVertex(W, W->back.upper, UPPER, &p, NULL);
+    insertVertex(W, W->back.lower, LOWER, &p, NULL);
+    return true;
+}
+
+/**
+ * Removes the oldest point of the window in O(log n) amortized time.
+ * @param  W The window
+ * @return   false if the window is empty, or out of memory
+ */
+int windowHullPop(windowHull *W) {
+    if (W->count == 0) return false;
+    if (W->frontCount == 0 && !refillFront(W))
+        return false;
+    undoFront(W);
+    W->head = (W->head + 1) % W->capacity;
+    W->count--;
+    return true;
+}
+
+/**
+ * Removes the points older than a given time from the window.
+ * @param  W    The window
+ * @param  time Time stamp of the oldest point to keep
+ * @return      Number of points removed
+ */
+int windowHullExpire(windowHull *W, double time) {
+    int k = 0;
+    while (W->count > 0 && entry(W, 0)->time < time && windowHullPop(W))
+        k++;
+    return k;
+}
+
+/**
+ * @return Number of points in the window
+ */
+int windowHullCount(windowHull *W) {
+    return W->count;
+}
+
+static int appendPoint(struct pointBuffer *S, const point *p) {
+    if (S->size == S->capacity) {
+        int capacity = (S->capacity > 0 ? 2*S->capacity : 64);
+        point *items = realloc(S->items, capacity*sizeof(point));
+        if (items == NULL) return false;
+        S->items = items;
+        S->capacity = capacity;
+    }
+    S->items[S->size++] = *p;
+    return true;
+}
+
+// Appends p to S in lexicographic order, unless it is already there
+static int appendVertex(struct pointBuffer *S, const point *p) {
+    if (S->size > 0 && comparePoints(&S->items[S->size-1], p) == 0)
+        return true;
+    return appendPoint(S, p);
+}
+
+static RBNode *firstNode(RBTree *T) {
+    return (RBisEmpty(T) ? T->nil : RBtreeMinimum(T, T->root));
+}
+
+// Lists the vertices of a hull in lexicographic order
+static int sortedVertices(struct windowPart *H, struct pointBuffer *S) {
+    RBTree *U = H->upper, *L = H->lower;
+    RBNode *a = firstNode(U), *b = firstNode(L);
+    S->size = 0;
+    while (!RBisLeaf(U, a) || !RBisLeaf(L, b)) {
+        RBNode **next = (RBisLeaf(L, b) || (!RBisLeaf(U, a)
+                         && comparePoints(partPoint(a), partPoint(b)) <= 0) ? &a : &b);
+        if (!appendVertex(S, partPoint(*next)))
+            return false;
+        *next = (next == &a ? RBtreeSuccessor(U, a) : RBtreeSuccessor(L, b));
+    }
+    return true;
+}
+
+/**
+ * Computes the hull of the window in time linear in the size of the front
+ * and back hulls, in the same order as convexHullIndices(): clockwise from
+ * the lexicographically smallest point.
+ * @param  W   The window
+ * @param  out Receives the vertices of the hull, or NULL to only count them
+ * @return     Number of vertices of the hull, or -1 if out of memory
+ */
+int windowHullVertices(windowHull *W, point *out) {
+    struct pointBuffer *F = &W->scratch[0], *B = &W->scratch[1], *S = &W->scratch[2];
+    if (!sortedVertices(&W->front, F) || !sortedVertices(&W->back, B))
+        return -1;
+    S->size = 0;
+    for (int i=0, j=0; i<F->size || j<B->size; ) {
+        const point *p = (j == B->size || (i < F->size
+                          && comparePoints(&F->items[i], &B->items[j]) <= 0)
+                          ? &F->items[i++] : &B->items[j++]);
+        if (!appendVertex(S, p))
+            return -1;
+    }
+    if (S->size+1 > W->indicesCapacity) {
+        int *indices = realloc(W->indices, (S->size+1)*sizeof(int));
+        if (indices == NULL) return -1;
+        W->indices = indices;
+        W->indicesCapacity = S->size+1;
+    }
+    int h = convexHullSorted(S->items, S->size, W->indices);
+    if (out != NULL)
+        for (int i=0; i<h; i++)
+            out[i] = S->items[W->indices[i]];
+    return h;
+}
+
+void windowHullFree(windowHull *W) {
+    if (W == NULL) return;
+    freeTree(W->front.upper);
+    freeTree(W->front.lower);
+    freeTree(W->back.upper);
+    freeTree(W->back.lower);
+    while (W->chunks != NULL) {
+        struct windowNodes *chunk = W->chunks;
+        W->chunks = chunk->next;
+        free(chunk);
+    }
+    free(W->entries);
+    free(W->undo);
+    free(W->removed);
+    for (int i=0; i<3; i++)
+        free(W->scratch[i].items);
+    free(W->indices);
+    free(W);
+}
@@ -0,0 +1,65 @@
+#ifndef __windowhull_h
+#define __windowhull_h
+
+#include "convexhull.h"
+#include "lib/rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The upper and lower part of a hull, as in onlineHull
+struct windowPart {
+    RBTree *upper;
+    RBTree *lower;
+};
+
+// A point of the window with its time stamp
+struct windowEntry {
+    point p;
+    double time;
+};
+
+struct pointBuffer {
+    point *items;
+    int size, capacity;
+};
+
+/**
+ * Convex hull of a sliding window over a stream of points: points are
+ * pushed at the back and popped at the front, like a queue made of two
+ * stacks. The back is the hull of the newer points under insertions. The
+ * front is the hull of the older points, inserted from newest to oldest with
+ * an undo log, so popping the oldest point undoes its insertion. When the
+ * front runs empty, the back is moved over. The hull of the window is the
+ * merge of both.
+ */
+typedef struct windowHull {
+    struct windowEntry *entries; // ring buffer of the points in the window
+    int head, count, capacity;
+    int frontCount;              // the oldest points, in the front hull
+    struct windowPart front, back;
+    struct windowUndo *undo;     // undo log of the front, oldest point on top
+    RBNode **removed;            // nodes removed by insertions into the front
+    int removedSize;
+    struct windowNodes *chunks;  // tree nodes, allocated in chunks
+    RBNode *freeNodes;
+    int freeCount;
+    struct pointBuffer scratch[3];
+    int *indices;
+    int indicesCapacity;
+} windowHull;
+
+windowHull *windowHullInit(void);
+int windowHullPush(windowHull *W, point p, double time);
+int windowHullPop(windowHull *W);
+int windowHullExpire(windowHull *W, double time);
+int windowHullCount(windowHull *W);
+int windowHullVertices(windowHull *W, point *out);
+void windowHullFree(windowHull *W);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __windowhull_h */